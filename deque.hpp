@@ -3,52 +3,299 @@
 
 #include "exceptions.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
 #include <utility>
 #include <cmath>
 
+//-mavx2 / -msse4.1 打开对应的核 SJTU_NO_SIMD全部关掉
+#if !defined(SJTU_NO_SIMD) && (defined(__AVX2__) || defined(__SSE2__))
+#include <immintrin.h>
+#endif
+
 namespace sjtu {
 
+/**
+ * a slab allocator for list nodes.
+ * nodes are cut from slabs of growing size and kept in a free list after
+ * being returned, so pushes and pops don't go to the global allocator.
+ * the pool is shared (reference counted) by every list that owns nodes
+ * from it, e.g. all the chunks of one deque.
+ * once share() is called (a deque snapshot uses it too, maybe from
+ * another thread) every allocation takes a spin lock.
+ * a pool can take over nodes of another one (adopt, used when a deque
+ * hands chunks to another): they are freed into the new pool from then
+ * on, and the slabs they live in stay alive as long as either pool
+ * refers to them, so neither pool needs the lock for that.
+ */
+template<class Node> class node_pool{
+  public:
+    struct slab{
+      slab *next;
+    };
+    //一个pool开出来的slab 借走过节点的pool也指着它 都不用了才释放
+    struct arena{
+      slab *slabs;
+      std::atomic<size_t> refs;
+      arena() : slabs(nullptr), refs(1) {}
+      ~arena() {
+        while(slabs) {
+          slab *tmp = slabs;
+          slabs = slabs->next;
+          ::operator delete(tmp, std::align_val_t(alignof(Node)));
+        }
+      }
+      void attach() { refs++; }
+      void detach() {
+        if(--refs == 0)
+          delete this;
+      }
+    };
+    //adopt来的节点所在的arena
+    struct loan{
+      arena *a;
+      loan *next;
+    };
+    static constexpr size_t node_offset = (sizeof(slab) + alignof(Node) - 1) / alignof(Node) * alignof(Node);
+    static constexpr size_t min_slab = 16;
+    static constexpr size_t max_slab = 1024;
+    arena *own;
+    loan *loans;
+    void *free_list;
+    size_t slab_s, live, free_s;
+    std::atomic<size_t> refs;
+    std::atomic<bool> locking;
+    std::atomic_flag busy = ATOMIC_FLAG_INIT;
+    // --------------------------
+    node_pool() : own(nullptr), loans(nullptr), free_list(nullptr), slab_s(min_slab), live(0), free_s(0), refs(1), locking(false) {}
+    ~node_pool() { free_slabs(); }
+    //自己的arena和借来的都放掉 别的pool还在用的slab由它们留着
+    void free_slabs() {
+      if(own)
+        own->detach();
+      own = nullptr;
+      while(loans) {
+        loan *tmp = loans;
+        loans = loans->next;
+        tmp->a->detach();
+        delete tmp;
+      }
+      free_list = nullptr;
+      slab_s = min_slab;
+      free_s = 0;
+    }
+    static node_pool *create() { return new node_pool(); }
+    void attach() { refs++; }
+    void detach() {
+      if(--refs == 0)
+        delete this;
+    }
+    void share() { locking = true; }
+    //没共享过就不加锁
+    struct guard{
+      node_pool *p;
+      bool locked;
+      explicit guard(node_pool *p_) : p(p_), locked(p_->locking.load(std::memory_order_acquire)) {
+        if(locked)
+          while(p->busy.test_and_set(std::memory_order_acquire))
+            ;
+      }
+      ~guard() {
+        if(locked)
+          p->busy.clear(std::memory_order_release);
+      }
+    };
+    void grow() {
+      if(!own)
+        own = new arena();
+      slab *new_slab = static_cast<slab*>(::operator new(node_offset + slab_s * sizeof(Node), std::align_val_t(alignof(Node))));
+      new_slab->next = own->slabs;
+      own->slabs = new_slab;
+      char *first = reinterpret_cast<char*>(new_slab) + node_offset;
+      for(size_t i = slab_s; i > 0; i--) {
+        void *p = first + (i - 1) * sizeof(Node);
+        *static_cast<void**>(p) = free_list;
+        free_list = p;
+      }
+      free_s += slab_s;
+      if(slab_s < max_slab)
+        slab_s <<= 1;
+    }
+    void *allocate() {
+      guard g(this);
+      if(!free_list)
+        grow();
+      void *p = free_list;
+      free_list = *static_cast<void**>(p);
+      live++, free_s--;
+      return p;
+    }
+    void deallocate(Node *p) {
+      guard g(this);
+      *reinterpret_cast<void**>(p) = free_list;
+      free_list = p;
+      live--, free_s++;
+    }
+    /**
+     * grow until n nodes can be handed out without a new slab.
+     */
+    void reserve(size_t n) {
+      guard g(this);
+      while(free_s < n)
+        grow();
+    }
+    size_t spare() {
+      guard g(this);
+      return free_s;
+    }
+    /**
+     * give every slab back to the global allocator,
+     * only possible when no node is alive. slabs another pool still
+     * has nodes in are freed when that pool lets them go.
+     */
+    void release() {
+      guard g(this);
+      if(live == 0)
+        free_slabs();
+    }
+    /**
+     * take over n nodes in use that came from from: they will be
+     * deallocated into this pool, and the slabs of from stay alive
+     * while this pool may hold them. call it from the thread using from.
+     */
+    void adopt(node_pool *from, size_t n) {
+      if(from == this || n == 0)
+        return;
+      loan *got = nullptr;
+      {
+        guard g(from);
+        try {
+          if(from->own)
+            got = new loan{from->own, got};
+          for(loan *l = from->loans; l; l = l->next)
+            got = new loan{l->a, got};
+        }catch(...) {
+          while(got) {
+            loan *next = got->next;
+            delete got;
+            got = next;
+          }
+          throw;
+        }
+        for(loan *l = got; l; l = l->next)
+          l->a->attach();
+        from->live -= n;
+      }
+      guard g(this);
+      live += n;
+      //已经借过的arena不重复记
+      while(got) {
+        loan *next = got->next;
+        bool known = got->a == own;
+        for(loan *l = loans; l && !known; l = l->next)
+          known = l->a == got->a;
+        if(known) {
+          got->a->detach();
+          delete got;
+        }else {
+          got->next = loans;
+          loans = got;
+        }
+        got = next;
+      }
+    }
+};
+/**
+ * the pool of chunks that don't need one (circular_array).
+ */
+struct null_pool{
+  static null_pool *create() { return nullptr; }
+  void attach() {}
+  void detach() {}
+  void share() {}
+  void release() {}
+  void adopt(null_pool *, size_t) {}
+  void reserve(size_t) {}
+  size_t spare() { return 0; }
+};
+
 template<class T> class double_list{
   public:
     struct Node{
-      T* data;
       Node *pre, *next;
-      Node() : data(nullptr), pre(nullptr), next(nullptr){}
-      Node(T* d, Node* pre_, Node* next) : data(d), pre(pre_), next(next){};
-      Node(const Node& other) {
-        if(other.data)
-          data = new T(*other.data);
-        else
-          data = nullptr;
-        pre = other.pre, next = other.next;
+      //只有tail_node没有值
+      bool valued;
+      //元素直接放在节点里 不再单独new一个T
+      alignas(T) unsigned char storage[sizeof(T)];
+      Node() : pre(nullptr), next(nullptr), valued(false){}
+      template<class... Args>
+      Node(Node* pre_, Node* next_, Args&&... args) : pre(pre_), next(next_), valued(true) {
+        new (storage) T(std::forward<Args>(args)...);
       }
-      Node& operator=(const Node& other) {
-        if(this == &other)
-          return *this;
-        delete data;
-        if(other.data)
-          data = new T(*other.data);
-        else
-          data = nullptr;
-        pre = other.pre, next = other.next;
-        return *this;
+      Node(const Node& other) = delete;
+      Node& operator=(const Node& other) = delete;
+      ~Node() {
+        if(valued)
+          data()->~T();
       }
-      ~Node() { delete data; }
-      bool operator==(const Node &other) const { return data == other.data; }
+      T *data() { return reinterpret_cast<T*>(storage); }
     };
     // --------------------------
     //注意前后两个点都要记录
     Node *head, *tail;
     size_t s;
     Node tail_node;
+    //节点都从pool里拿 第一次用到时才创建
+    using pool_type = node_pool<Node>;
+    pool_type *pool;
+    //迭代器记的是节点 块被复制之后要回原来的链表里数位置
+    static constexpr bool keeps_nodes = true;
+    //节点得从pool里拿 没法放进deque对象里(见deque::local)
+    static constexpr bool local_storage = false;
+    // --------------------------
+    Node *new_node_space() {
+      if(!pool)
+        pool = pool_type::create();
+      return static_cast<Node*>(pool->allocate());
+    }
+    //构造失败要把位置还给pool
+    template<class... Args>
+    Node *make_node(Args&&... args) {
+      Node *p = new_node_space();
+      try {
+        return new (p) Node(std::forward<Args>(args)...);
+      }catch(...) {
+        pool->deallocate(p);
+        throw;
+      }
+    }
+    void delete_node(Node *p) {
+      p->~Node();
+      pool->deallocate(p);
+    }
     // --------------------------
     //doublelist的构造需要深拷贝！
-    double_list() : tail_node() {
+    double_list() : tail_node(), pool(nullptr) {
       head = &tail_node, tail = &tail_node;
       s = 0;
     }
-    double_list(Node* head_, Node* tail_, size_t s_) : double_list() {
+    /**
+     * an empty list taking its nodes from pool_.
+     */
+    explicit double_list(pool_type *pool_) : double_list() {
+      pool = pool_;
+      if(pool)
+        pool->attach();
+    }
+    //这些节点原来属于pool_
+    double_list(Node* head_, Node* tail_, size_t s_, pool_type *pool_) : double_list(pool_) {
       // double_list();
       this->add(head_, tail_, s_);
     }
@@ -71,11 +318,100 @@ template<class T> class double_list{
       return *this;
     }
     double_list& add(double_list<T> &&other) {
+      if(other.empty())
+        return *this;
+      if(!pool) {
+        pool = other.pool;
+        pool->attach();
+      }
+      if(pool != other.pool) {
+        //节点来自别的pool 不能直接接过来
+        for(auto it = other.begin(); it != other.end(); ++it)
+          emplace_tail(std::move(*it));
+        other.clear();
+        return *this;
+      }
       add(other.head, other.tail, other.size());
       other.head = other.tail;
+      other.tail->pre = nullptr;
       other.s = 0;
       return *this;
     }
+    /**
+     * move the elements from the k-th on to the end of to.
+     * the nodes are only relinked if both lists use the same pool.
+     */
+    void cut(size_t k, double_list &to) {
+      if(k >= s)
+        return;
+      if(!to.pool) {
+        to.pool = pool;
+        pool->attach();
+      }
+      if(to.pool != pool) {
+        for(iterator it = nth(k); it != end(); ++it)
+          to.emplace_tail(std::move(*it));
+        erase(nth(k), end());
+        return;
+      }
+      Node *first_ = nth(k).current, *pre = first_->pre;
+      to.add(first_, tail, s - k);
+      tail->pre = pre;
+      if(pre)
+        pre->next = tail;
+      else
+        head = tail;
+      s = k;
+    }
+    /**
+     * move the first element to the end of to, only the node is relinked
+     * if both lists use the same pool.
+     */
+    void move_head(double_list &to) {
+      if(!to.pool) {
+        to.pool = pool;
+        pool->attach();
+      }
+      if(to.pool != pool) {
+        to.emplace_tail(std::move(*head->data()));
+        delete_head();
+        return;
+      }
+      Node *p = head;
+      head = p->next;
+      head->pre = nullptr;
+      s--;
+      p->pre = to.tail->pre;
+      p->next = to.tail;
+      if(p->pre)
+        p->pre->next = p;
+      else
+        to.head = p;
+      to.tail->pre = p;
+      to.s++;
+    }
+    /**
+     * sort by comp. the node pointers are sorted in an array and the nodes
+     * relinked in that order, no element is moved; if comp throws the
+     * list is unchanged.
+     */
+    template<class Comp> void sort(Comp &comp) {
+      if(s < 2)
+        return;
+      std::unique_ptr<Node*[]> a(new Node*[s]);
+      size_t i = 0;
+      for(Node *p = head; p != tail; p = p->next)
+        a[i++] = p;
+      std::sort(a.get(), a.get() + s, [&](Node *x, Node *y) { return comp(*x->data(), *y->data()); });
+      head = a[0];
+      head->pre = nullptr;
+      for(i = 0; i + 1 < s; i++) {
+        a[i]->next = a[i + 1];
+        a[i + 1]->pre = a[i];
+      }
+      a[s - 1]->next = tail;
+      tail->pre = a[s - 1];
+    }
     double_list& operator=(const double_list<T>& other) {
       if (this == &other) 
         return *this;
@@ -84,15 +420,21 @@ template<class T> class double_list{
         insert_tail(*it);
       return *this;
     }
-    ~double_list() {clear(); }
+    ~double_list() {
+      clear();
+      if(pool)
+        pool->detach();
+    }
   
     class iterator{
     public:
       Node *current;
       const double_list *current_list;
+      //在链表里的下标 块被复制之后靠它找回同一个位置
+      size_t idx;
       // --------------------------
-      iterator() : current(nullptr), current_list(nullptr){}
-      iterator(Node *current_, const double_list *current_list_) : current(current_), current_list(current_list_) {}
+      iterator() : current(nullptr), current_list(nullptr), idx(0){}
+      iterator(Node *current_, const double_list *current_list_, size_t idx_) : current(current_), current_list(current_list_), idx(idx_) {}
       iterator(const iterator &t) = default;
       ~iterator(){}
           /**
@@ -108,6 +450,7 @@ template<class T> class double_list{
        */
       iterator &operator++() {
         current = current -> next;
+        idx++;
         return *this;	
       }
           /**
@@ -123,6 +466,7 @@ template<class T> class double_list{
        */
       iterator &operator--() {
         current = current->pre;
+        idx--;
         return *this;
       }
       /**
@@ -130,29 +474,63 @@ template<class T> class double_list{
        * throw " invalid"
       */
       T &operator*() const {
-        if(current == nullptr || current->data == nullptr)
+        if(current == nullptr || !current->valued)
           throw invalid_iterator();
-        return *(current->data);
+        return *(current->data());
       }
           /**
            * other operation
           */
-      T *operator->() const noexcept { return (current->data);}
+      T *operator->() const noexcept { return (current->data());}
       bool operator==(const iterator &rhs) const { return current == rhs.current;}
       bool operator!=(const iterator &rhs) const { return current != rhs.current;}
     };
     /**
      * return an iterator to the beginning
      */
-    // iterator begin(){return iterator(head, this);}
+    // iterator begin(){return iterator(head, this, 0);}
     /**
      * return an iterator to the ending
      * in fact, it returns the iterator point to nothing,
      * just after the last element.
      */
-    // iterator end(){return iterator(tail, this);}
-    iterator begin() const { return iterator(head, this); }
-    iterator end() const { return iterator(tail, this); }
+    // iterator end(){return iterator(tail, this, s);}
+    iterator begin() const { return iterator(head, this, 0); }
+    iterator end() const { return iterator(tail, this, s); }
+    /**
+     * a node range handed out by segments(): ++ and * don't check
+     * anything, so a scan over a chunk is just a pointer chase.
+     */
+    class segment_iterator{
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = T;
+      using difference_type = std::ptrdiff_t;
+      using pointer = T*;
+      using reference = T&;
+      Node *current;
+      explicit segment_iterator(Node *current_ = nullptr) : current(current_) {}
+      segment_iterator &operator++() {
+        current = current->next;
+        return *this;
+      }
+      segment_iterator operator++(int) {
+        segment_iterator old = *this;
+        current = current->next;
+        return old;
+      }
+      T &operator*() const { return *current->data(); }
+      T *operator->() const { return current->data(); }
+      bool operator==(const segment_iterator &rhs) const { return current == rhs.current; }
+      bool operator!=(const segment_iterator &rhs) const { return current != rhs.current; }
+    };
+    /**
+     * give [first, last) to f as one segment f(b, e).
+     * return what f returns (false means stop).
+     */
+    template<class F> bool segments(iterator first, iterator last, F &f) const {
+      return f(segment_iterator(first.current), segment_iterator(last.current));
+    }
     /**
      * if the iter didn't point to anything, do nothing,
      * otherwise, delete the element pointed by the iter
@@ -178,41 +556,76 @@ template<class T> class double_list{
       Node *tmp = pos.current, *tmp_ = tmp->next;
       tmp->pre->next = tmp->next;
       tmp->next->pre = tmp->pre;
-      delete tmp;
+      delete_node(tmp);
       //把tmp_定义在这里next就错了
-      return iterator(tmp_, this);
+      return iterator(tmp_, this, pos.idx);
+    }
+    /**
+     * delete the elements in [first, last), return last.
+     */
+    iterator erase(iterator first, iterator last) {
+      if(first.current_list != this || last.current_list != this)
+        throw invalid_iterator();
+      Node *it_ = first.current, *pre = it_->pre;
+      while(it_ != last.current) {
+        Node *next = it_->next;
+        delete_node(it_);
+        s--;
+        it_ = next;
+      }
+      it_->pre = pre;
+      if(pre)
+        pre->next = it_;
+      else
+        head = it_;
+      return iterator(it_, this, first.idx);
     }
     /**
      * the following are operations of double list
     */
     iterator insert(iterator pos, const T &val) {
+      return emplace(pos, val);
+    }
+    void insert_head(const T &val){
+      emplace_head(val);
+    }
+    void insert_tail(const T &val){
+      emplace_tail(val);
+    }
+    /**
+     * construct the element in place from args.
+     */
+    template<class... Args>
+    iterator emplace(iterator pos, Args&&... args) {
       if(pos == iterator() || pos.current_list != this)
         throw invalid_iterator();
       if(pos == begin()) {
-        insert_head(val);
+        emplace_head(std::forward<Args>(args)...);
         return begin();
       }
       else if(pos == end()) {
-        insert_tail(val);
+        emplace_tail(std::forward<Args>(args)...);
         return --end();
       }
-      s++;
       Node* it_ = pos.current;
-      Node* substitute = new Node(new T(val), it_->pre, it_);
+      Node* substitute = make_node(it_->pre, it_, std::forward<Args>(args)...);
+      s++;
       if(it_->pre)
         it_->pre->next = substitute;
       it_->pre = substitute;
-      return iterator(substitute, this);
+      return iterator(substitute, this, pos.idx);
     }
-    void insert_head(const T &val){
+    template<class... Args>
+    void emplace_head(Args&&... args){
+      Node* new_node = make_node(nullptr, head, std::forward<Args>(args)...);
       s++;
-      Node* new_node = new Node(new T(val), nullptr, head);
       head->pre = new_node;
       head = new_node;
     }
-    void insert_tail(const T &val){
+    template<class... Args>
+    void emplace_tail(Args&&... args){
+      Node *new_node = make_node(tail->pre, tail, std::forward<Args>(args)...);
       s++;
-      Node *new_node = new Node(new T(val), tail->pre, tail);
       if(!tail->pre) //原来是空的
         head = new_node;
       else {
@@ -231,7 +644,7 @@ template<class T> class double_list{
       Node *old = head;
       head = head->next;
       head->pre = nullptr;
-      delete old;
+      delete_node(old);
     }
     void delete_tail(){
       if (empty()) 
@@ -243,7 +656,7 @@ template<class T> class double_list{
       else
         head = tail;
       tail->pre = last->pre;
-      delete last;
+      delete_node(last);
     }
     bool empty () const{
       return (head == tail);
@@ -252,297 +665,1503 @@ template<class T> class double_list{
       Node* tmp = head;
       while (tmp != tail) {
         tmp = tmp -> next;
-        delete tmp->pre;
+        delete_node(tmp->pre);
       }
-      tail_node = Node();
+      tail_node.pre = tail_node.next = nullptr;
       head = &tail_node;
       tail = &tail_node;
       // head = tail;
       s = 0;
     }
+    //节点都在pool里 预留和收缩都交给pool
+    void reserve(size_t) {}
+    void shrink_to_fit() {}
+    size_t capacity() const { return s; }
+    /**
+     * let p take over the nodes (see node_pool::adopt): they are freed
+     * into p and new ones come from p from now on.
+     */
+    void move_to(pool_type *p) {
+      if(p == pool)
+        return;
+      if(pool) {
+        p->adopt(pool, s);
+        pool->detach();
+      }
+      p->attach();
+      pool = p;
+    }
     // void print() const {
     //   Node *tmp = head;
     //   while(tmp) {
-    //     std::cout << *tmp->data << " ";
+    //     std::cout << *tmp->data() << " ";
     //     tmp = tmp->next;
     //   }
     //   std::cout << std::endl;
     // }
     //-----------------------------
     size_t size() { return s; }
-    //merge version1
-    // static double_list merge(double_list &a, double_list &b) { //因为它们操作的是参数，而不是类自身的成员变量->static
-    //   double_list merge_ans;
-    //   for(auto merge_it = a.begin(); merge_it != a.end(); merge_it++)
-    //     merge_ans.insert_tail(*merge_it);
-    //   for(auto merge_it = b.begin(); merge_it != b.end(); merge_it++)
-    //     merge_ans.insert_tail(*merge_it);
-    //   return merge_ans;
-    // }
-    //merge version2
-    static double_list merge(double_list &a, double_list &b) {
-      return std::move(a.add(std::move(b)));
-    }
-    static std::pair<double_list, double_list> split(double_list &a, size_t split_pos) { 
-      if(a.size() < split_pos)
-        throw runtime_error();
-      if(split_pos == 0)
-        return std::make_pair(double_list(), a);
-      else if(split_pos == a.size())
-        return std::make_pair(a, double_list());
-      Node *it_ = a.head;
-      //这里的i要从1开始不然的话就不对了！！！
-      size_t i = 1;
-      while(i <= split_pos) {
-        it_ = it_->next;
-        i++;
-      }
-      double_list<T> front = double_list(a.head, it_, split_pos);
-      //注意这里不包含最后一个元素的
-      double_list<T> back = double_list(it_, a.tail, a.size() - split_pos);
-      a.head = a.tail;
-      a.s = 0;
-      return std::make_pair(front, back);
-    }
     static size_t init_size(const double_list &list_, const iterator& chunk_it_) { //同一个list的chunk到开头的距离
+      //往两头同时走 先碰到哪头就用哪头算
+      Node *front_ = chunk_it_.current, *back_ = chunk_it_.current;
       size_t cnt = 0;
-      for (iterator it_ = list_.begin(); it_ != chunk_it_ && it_ != list_.end(); it_++)
+      while(true) {
+        if(front_ == list_.head)
+          return cnt;
+        if(back_ == list_.tail)
+          return list_.s - cnt;
+        front_ = front_->pre;
+        back_ = back_->next;
         cnt++;
-      return cnt;
+      }
     }
-};
-template <class T> class deque {
-public:
-  using chunk_it_type = typename double_list<T>::iterator;
-  using list_it_type = typename double_list<double_list<T>>::iterator;
-  static constexpr double spilt_index = 1.5;
-  static constexpr double merge_index = 0.5;
-
-public:
-  double_list<double_list<T>> data;
-  size_t sum_s;
-  size_t chunk_s;
-  class const_iterator;
-  size_t standard_size() const {
-    return floor(sqrt(sum_s)) + 1;
-  }
-  //------------------------------
-  class iterator {
-  public:
-    deque *dq_it;
-    list_it_type list_it;
-    chunk_it_type chunk_it;
-    //--------------------------
-    iterator() : dq_it(nullptr), list_it(), chunk_it(){}
-    iterator(deque* dq_it_, const list_it_type& list_it_, const chunk_it_type &chunk_it_) : dq_it(dq_it_), list_it(list_it_), chunk_it(chunk_it_){} 
     /**
-     * return a new iterator which points to the n-next element.
-     * if there are not enough elements, the behaviour is undefined.
-     * same for operator-.
+     * return an iterator to the k-th element (end() if k == size),
+     * walking from whichever end is closer.
      */
-    iterator operator+(const int &n) const {
-      if(*this == iterator())
-        throw invalid_iterator();
-      if(n == 0)
-        return *this;
-      if(n < 0)
-        return (*this) - (-n);
-      // 注意这里是可以--end()的 所以对end的判断要写在这个之后
-      if(*this == dq_it->end())
-        throw index_out_of_bound();
-      int n_ = n;
-      list_it_type list_it_ = list_it;
-      chunk_it_type chunk_it_ = chunk_it;
-      while(n_ > 0 && chunk_it_ != --(list_it_->end())) {
-        chunk_it_++;
-        n_--;
-      }
-      if(n_ == 0)
-        return iterator(dq_it, list_it_, chunk_it_);
-      if(list_it_ == --(dq_it->data.end())) {
-        if(n_ != 1)
-          throw index_out_of_bound();
-        else
-          return (dq_it)->end();
-      } else 
-        list_it_++;
-      while(list_it_ != (dq_it->data.end()) && n_ > list_it_->size()) {
-        n_ -= list_it_->size();
-        list_it_++;
-      }
-      // ??????????????????????????
-      if(list_it_ == (dq_it->data.end())) {
-        //std::cout << "in end" << std::endl;
-        if(n_ > 1)
-          throw index_out_of_bound();
-        else
-          return (dq_it)->end();
-      }
-      chunk_it_ = list_it_->begin();
-      for (int i = 0; i < n_ - 1; ++i) {
-          ++chunk_it_;
-      }
-      return iterator(dq_it, list_it_, chunk_it_);
-    }
-    iterator operator-(const int &n) const {
-      if(*this == iterator())
-        throw invalid_iterator(); //指向begin的之后未必直接throw
-      if(n == 0)
-        return *this;
-      else if(n < 0)
-        return (*this) + (-n);
-      int n_ = n;
-      list_it_type list_it_ = list_it;
-      chunk_it_type chunk_it_ = chunk_it;
-      if(*this == dq_it->end()) {
-        list_it_--;
+    iterator nth(size_t k) const {
+      Node *it_ = head;
+      if(k * 2 <= s) {
+        for(size_t i = 0; i < k; i++)
+          it_ = it_->next;
       }else {
-        while(n_ > 0 && chunk_it_ != list_it_->begin()) {
-          n_--;
-          chunk_it_--;
-        }
-        if(n_ == 0)
-          return iterator(dq_it, list_it_, chunk_it_);
-        if(list_it_ == (dq_it->data.begin())) 
-          throw index_out_of_bound();
-        list_it_--;
-      }
-      while(n_ > int(list_it_->size()) && list_it_ != dq_it->data.begin()) {
-        n_ -= list_it_->size();
-        list_it_--;
+        it_ = tail;
+        for(size_t i = s; i > k; i--)
+          it_ = it_->pre;
       }
-      if (n_ > int(list_it_->size()))
-        throw index_out_of_bound();
-      chunk_it_ = list_it_->begin();
-      for(int i = 0; i < list_it_->size() - n_; i++)
-        chunk_it_++;
-      return iterator(dq_it, list_it_, chunk_it_);
+      return iterator(it_, this, k);
     }
     /**
-     * return the distance between two iterators.
-     * if they point to different vectors, throw
-     * invaild_iterator.
+     * move it forward by at most n elements without passing the last one,
+     * n is decreased by the number of steps taken.
      */
-    int operator-(const iterator &rhs) const {
-      if(dq_it != rhs.dq_it)
-        throw invalid_iterator();
-      if(list_it == rhs.list_it) {
-        if(list_it == dq_it->data.end())
-          return 0;
-        return static_cast<int>(double_list<T>::init_size(*(this->list_it), this->chunk_it)) - double_list<T>::init_size(*(rhs.list_it), rhs.chunk_it);
-      }
-      bool greater = double_list<double_list<T>>::init_size(dq_it->data, this->list_it) > double_list<double_list<T>>::init_size(dq_it->data, rhs.list_it);
-      list_it_type list_it_front = this->list_it, list_it_back = rhs.list_it;
-      chunk_it_type chunk_it_front = this->chunk_it, chunk_it_back = rhs.chunk_it;
-      if(greater) {
-        std::swap(list_it_front, list_it_back);
-        std::swap(chunk_it_front, chunk_it_back);
-      }
-      int res = static_cast<int>(list_it_front->size()) - double_list<T>::init_size(*list_it_front, chunk_it_front);
-      if(list_it_back != dq_it->data.end())
-        res += double_list<T>::init_size(*list_it_back, chunk_it_back);
-      else
-        res += 0;
-      ++list_it_front;
-      while(list_it_front != list_it_back) {
-        res += list_it_front->size();
-        list_it_front++;
-      }
-      if(greater)
-        return res;
-      else
-        return -res;
-    }
-    iterator &operator+=(const int &n) {
-      return *this = *this + n;
-    }
-    iterator &operator-=(const int &n) {
-      return *this = *this - n;
+    iterator step_forward(iterator it, int &n) const {
+      while(n > 0 && it.current != tail->pre) {
+        it.current = it.current->next;
+        it.idx++;
+        n--;
+      }
+      return it;
     }
-
     /**
-     * iter++
+     * move it backward by at most n elements without passing the first one,
+     * n is decreased by the number of steps taken.
      */
-    iterator operator++(int) {
-      iterator old = *this;
-      *this = *this + 1;
-      return old;
+    iterator step_backward(iterator it, int &n) const {
+      while(n > 0 && it.current != head) {
+        it.current = it.current->pre;
+        it.idx--;
+        n--;
+      }
+      return it;
     }
-    /**
-     * ++iter
-     */
-    iterator &operator++() {
-      return *this = *this + 1;
+};
+
+/**
+ * a chunk stored in one contiguous ring buffer.
+ * it has the same interface as double_list, so deque can use it as chunk:
+ *   sjtu::deque<T, sjtu::circular_array<T>>
+ * the capacity is a power of two and only grows (doubles) when it is full,
+ * which is rare since deque splits big chunks long before.
+ */
+template<class T> class circular_array{
+  public:
+    T *buf;
+    size_t cap, head, s;
+    //放在别的对象里的数组(见local_space) 不能delete 也不能被拿走
+    T *fixed;
+    // --------------------------
+    T *slot(size_t k) const { return buf + ((head + k) & (cap - 1)); }
+    static size_t round_cap(size_t n) {
+      size_t c = 8;
+      while(c < n)
+        c <<= 1;
+      return c;
     }
-    /**
-     * iter--
-     */
-    iterator operator--(int) {
-      iterator old = *this;
-      *this = *this - 1;
-      return old;
+    //元素挪到c个位置的新数组
+    void relocate(size_t c) {
+      T *new_buf = static_cast<T*>(::operator new(c * sizeof(T), std::align_val_t(alignof(T))));
+      for(size_t i = 0; i < s; i++) {
+        new (new_buf + i) T(std::move(*slot(i)));
+        slot(i)->~T();
+      }
+      free_buf();
+      buf = new_buf, cap = c, head = 0;
     }
-    /**
-     * --iter
-     */
-    iterator &operator--() {
-      return *this = *this - 1;
+    void free_buf() {
+      if(buf != fixed)
+        ::operator delete(buf, std::align_val_t(alignof(T)));
     }
-
-    /**
-     * *it
-     */
-    T &operator*() const {
-      return *chunk_it;
+    void reserve(size_t new_cap) {
+      if(new_cap > cap)
+        relocate(round_cap(new_cap));
     }
-    /**
-     * it->field
-     */
-    T *operator->() const noexcept {
-      return chunk_it.operator->();
+    void shrink_to_fit() {
+      if(buf == fixed)
+        return;
+      if(s == 0) {
+        ::operator delete(buf, std::align_val_t(alignof(T)));
+        buf = nullptr, cap = head = 0;
+      }else if(round_cap(s) < cap)
+        relocate(round_cap(s));
     }
-
+    size_t capacity() const { return cap; }
+    // --------------------------
+    using pool_type = null_pool;
+    //迭代器记的是下标 复制出来的块里下标不变
+    static constexpr bool keeps_nodes = false;
+    //可以用别的对象里的数组 见local_space
+    static constexpr bool local_storage = true;
+    // --------------------------
+    circular_array() : buf(nullptr), cap(0), head(0), s(0), fixed(nullptr) {}
+    explicit circular_array(pool_type *) : circular_array() {}
     /**
-     * check whether two iterators are the same (pointing to the same
-     * memory).
+     * room for N elements (a power of two) inside another object, see
+     * deque::local. a chunk on it only moves to a buffer of its own when
+     * it grows past N.
      */
-    bool operator==(const iterator &rhs) const {
-      if(dq_it == rhs.dq_it && list_it == rhs.list_it && chunk_it == rhs.chunk_it)
-        return true;
-      return false;
+    template<size_t N> struct local_space{
+      alignas(T) unsigned char data[N * sizeof(T)];
+    };
+    template<size_t N> explicit circular_array(local_space<N> &space) : buf(reinterpret_cast<T*>(space.data)), cap(N), head(0), s(0), fixed(buf) {}
+    void move_to(pool_type *) {}
+    circular_array(const circular_array &other) : circular_array() {
+      *this = other;
     }
-    bool operator==(const const_iterator &rhs) const {
-      if(dq_it == rhs.dq_it && list_it == rhs.list_it && chunk_it == rhs.chunk_it)
-        return true;
-      return false;
+    circular_array(circular_array &&other) : circular_array() {
+      *this = std::move(other);
     }
-    /**
-     * some other operator for iterators.
-     */
-    bool operator!=(const iterator &rhs) const {
-      return !(*this == rhs);
+    circular_array& operator=(circular_array &&other) {
+      if(this == &other)
+        return *this;
+      clear();
+      if(other.fixed && other.buf == other.fixed) {
+        //对面的数组拿不走 元素一个个挪过来
+        reserve(other.s);
+        for(size_t i = 0; i < other.s; i++)
+          new (buf + i) T(std::move(*other.slot(i)));
+        s = other.s;
+        other.clear();
+        return *this;
+      }
+      free_buf();
+      buf = other.buf, cap = other.cap, head = other.head, s = other.s;
+      other.buf = nullptr;
+      other.cap = other.head = other.s = 0;
+      return *this;
     }
-    bool operator!=(const const_iterator &rhs) const {
-      return !(*this == rhs);
+    circular_array& operator=(const circular_array &other) {
+      if(this == &other)
+        return *this;
+      clear();
+      reserve(other.s);
+      //一个个算进s 拷贝构造抛出时已经复制的还能析构
+      for(size_t i = 0; i < other.s; i++, s++)
+        new (buf + i) T(*other.slot(i));
+      return *this;
+    }
+    ~circular_array() {
+      clear();
+      free_buf();
     }
-  };
 
-  class const_iterator {
-    /**
-     * it should has similar member method as iterator.
-     * you can copy them, but with care!
-     * and it should be able to be constructed from an iterator.
-     */
-   public:
-    const deque *dq_it;
-    list_it_type list_it;
-    chunk_it_type chunk_it;
-    //--------------------------
-    const_iterator() : dq_it(nullptr), list_it(), chunk_it(){}
-    const_iterator(const deque *dq_it_, const list_it_type list_it_, const chunk_it_type chunk_it_) : dq_it(dq_it_), list_it(list_it_), chunk_it(chunk_it_){} 
-    const_iterator(const iterator &other) : dq_it(other.dq_it), list_it(other.list_it), chunk_it(other.chunk_it){}
-    /**
-     * return a new iterator which points to the n-next element.
+    class iterator{
+    public:
+      size_t idx;
+      const circular_array *current_list;
+      // --------------------------
+      iterator() : idx(0), current_list(nullptr){}
+      iterator(size_t idx_, const circular_array *current_list_) : idx(idx_), current_list(current_list_) {}
+      iterator(const iterator &t) = default;
+      iterator operator++(int) {
+        iterator old = *this;
+        ++*this;
+        return old;
+      }
+      iterator &operator++() {
+        idx++;
+        return *this;
+      }
+      iterator operator--(int) {
+        iterator old = *this;
+        --*this;
+        return old;
+      }
+      iterator &operator--() {
+        idx--;
+        return *this;
+      }
+      /**
+       * if the iter didn't point to a value
+       * throw " invalid"
+      */
+      T &operator*() const {
+        if(current_list == nullptr || idx >= current_list->s)
+          throw invalid_iterator();
+        return *current_list->slot(idx);
+      }
+      T *operator->() const noexcept { return current_list->slot(idx); }
+      bool operator==(const iterator &rhs) const { return idx == rhs.idx && current_list == rhs.current_list; }
+      bool operator!=(const iterator &rhs) const { return !(*this == rhs); }
+    };
+    iterator begin() const { return iterator(0, this); }
+    iterator end() const { return iterator(s, this); }
+    //从第k个开始连续的一截 p指向开头 返回长度
+    size_t span(size_t k, const T *&p) const {
+      p = slot(k);
+      return std::min(s - k, size_t(buf + cap - p));
+    }
+    //一段就是一截连续内存
+    using segment_iterator = T*;
+    /**
+     * give [first, last) to f as contiguous spans f(b, e), two of them if
+     * the range wraps around the end of buf.
+     * return false if f returns false (stop).
+     */
+    template<class F> bool segments(iterator first, iterator last, F &f) const {
+      size_t a = first.idx, b = last.idx;
+      if(a >= b)
+        return true;
+      T *p = slot(a);
+      size_t run = buf + cap - p;
+      if(b - a <= run)
+        return f(p, p + (b - a));
+      return f(p, buf + cap) && f(buf, buf + (b - a - run));
+    }
+    /**
+     * delete the element pointed by pos, the returned iterator points
+     * at the same index, i.e. the next element (or end()).
+     * the shorter side of the ring is shifted.
+    */
+    iterator erase(iterator pos) {
+      if(pos.current_list != this || pos.idx >= s)
+        throw invalid_iterator();
+      size_t k = pos.idx;
+      if(k < s / 2) {
+        for(size_t i = k; i > 0; i--)
+          *slot(i) = std::move(*slot(i - 1));
+        slot(0)->~T();
+        head = (head + 1) & (cap - 1);
+      }else {
+        for(size_t i = k; i + 1 < s; i++)
+          *slot(i) = std::move(*slot(i + 1));
+        slot(s - 1)->~T();
+      }
+      s--;
+      return iterator(k, this);
+    }
+    /**
+     * delete the elements in [first, last), the shorter side is shifted.
+    */
+    iterator erase(iterator first, iterator last) {
+      if(first.current_list != this || last.current_list != this || first.idx > last.idx || last.idx > s)
+        throw invalid_iterator();
+      size_t a = first.idx, b = last.idx, m = b - a;
+      if(m == 0)
+        return first;
+      if(a < s - b) {
+        for(size_t i = a; i > 0; i--)
+          *slot(i - 1 + m) = std::move(*slot(i - 1));
+        for(size_t i = 0; i < m; i++)
+          slot(i)->~T();
+        head = (head + m) & (cap - 1);
+      }else {
+        for(size_t i = b; i < s; i++)
+          *slot(i - m) = std::move(*slot(i));
+        for(size_t i = s - m; i < s; i++)
+          slot(i)->~T();
+      }
+      s -= m;
+      return iterator(a, this);
+    }
+    /**
+     * insert val before pos, the shorter side of the ring is shifted.
+    */
+    iterator insert(iterator pos, const T &val) {
+      return emplace(pos, val);
+    }
+    void insert_head(const T &val) {
+      emplace_head(val);
+    }
+    void insert_tail(const T &val) {
+      emplace_tail(val);
+    }
+    /**
+     * construct the element from args before pos.
+     */
+    template<class... Args>
+    iterator emplace(iterator pos, Args&&... args) {
+      if(pos.current_list != this || pos.idx > s)
+        throw invalid_iterator();
+      size_t k = pos.idx;
+      if(k == 0) {
+        emplace_head(std::forward<Args>(args)...);
+        return begin();
+      }
+      if(k == s) {
+        emplace_tail(std::forward<Args>(args)...);
+        return iterator(k, this);
+      }
+      //args可能引用着块里的元素 先构造出来再挪
+      T val(std::forward<Args>(args)...);
+      if(s == cap)
+        reserve(s + 1);
+      if(k < s / 2) {
+        new (slot(cap - 1)) T(std::move(*slot(0)));
+        head = (head + cap - 1) & (cap - 1);
+        for(size_t i = 1; i < k; i++)
+          *slot(i) = std::move(*slot(i + 1));
+      }else {
+        new (slot(s)) T(std::move(*slot(s - 1)));
+        for(size_t i = s - 1; i > k; i--)
+          *slot(i) = std::move(*slot(i - 1));
+      }
+      *slot(k) = std::move(val);
+      s++;
+      return iterator(k, this);
+    }
+    template<class... Args>
+    void emplace_head(Args&&... args) {
+      if(s == cap) {
+        T val(std::forward<Args>(args)...);
+        reserve(s + 1);
+        new (slot(cap - 1)) T(std::move(val));
+      }else
+        new (slot(cap - 1)) T(std::forward<Args>(args)...);
+      head = (head + cap - 1) & (cap - 1);
+      s++;
+    }
+    template<class... Args>
+    void emplace_tail(Args&&... args) {
+      if(s == cap) {
+        T val(std::forward<Args>(args)...);
+        reserve(s + 1);
+        new (slot(s)) T(std::move(val));
+      }else
+        new (slot(s)) T(std::forward<Args>(args)...);
+      s++;
+    }
+    void delete_head() {
+      if(empty())
+        throw container_is_empty();
+      slot(0)->~T();
+      head = (head + 1) & (cap - 1);
+      s--;
+    }
+    void delete_tail() {
+      if(empty())
+        throw container_is_empty();
+      slot(s - 1)->~T();
+      s--;
+    }
+    bool empty() const { return s == 0; }
+    void clear() {
+      for(size_t i = 0; i < s; i++)
+        slot(i)->~T();
+      head = 0;
+      s = 0;
+    }
+    size_t size() const { return s; }
+    /**
+     * move the elements of other to the end, other becomes empty.
+     */
+    circular_array& add(circular_array &&other) {
+      //自己是空的就直接接过other的数组
+      if(s == 0)
+        return *this = std::move(other);
+      reserve(s + other.s);
+      for(size_t i = 0; i < other.s; i++)
+        new (slot(s + i)) T(std::move(*other.slot(i)));
+      s += other.s;
+      other.clear();
+      return *this;
+    }
+    /**
+     * move the elements from the k-th on to the end of to.
+     */
+    void cut(size_t k, circular_array &to) {
+      if(k >= s)
+        return;
+      to.reserve(to.s + s - k);
+      for(size_t i = k; i < s; i++) {
+        new (to.slot(to.s++)) T(std::move(*slot(i)));
+        slot(i)->~T();
+      }
+      s = k;
+    }
+    //第一个元素挪到to的末尾
+    void move_head(circular_array &to) {
+      to.emplace_tail(std::move(*slot(0)));
+      delete_head();
+    }
+    /**
+     * sort by comp with std::sort on the buffer, a ring that wraps around
+     * is first moved into one piece.
+     */
+    template<class Comp> void sort(Comp &comp) {
+      if(s < 2)
+        return;
+      if(head + s > cap)
+        relocate(cap);
+      std::sort(buf + head, buf + head + s, [&](const T &a, const T &b) { return comp(a, b); });
+    }
+    static size_t init_size(const circular_array &, const iterator& chunk_it_) {
+      return chunk_it_.idx;
+    }
+    iterator nth(size_t k) const { return iterator(k, this); }
+    iterator step_forward(iterator it, int &n) const {
+      size_t room = s - 1 - it.idx;
+      size_t step = size_t(n) < room ? size_t(n) : room;
+      n -= int(step);
+      return iterator(it.idx + step, this);
+    }
+    iterator step_backward(iterator it, int &n) const {
+      size_t step = size_t(n) < it.idx ? size_t(n) : it.idx;
+      n -= int(step);
+      return iterator(it.idx - step, this);
+    }
+};
+
+//chunk_index放在对象里的小数组 N个槽
+template<class Ptr, size_t N> struct chunk_slots{
+  Ptr slots[N];
+  size_t slot_tree[N + 1];
+  chunk_slots() : slots(), slot_tree() {}
+  Ptr *small_map() { return slots; }
+  size_t *small_tree() { return slot_tree; }
+  void swap_slots(chunk_slots &other) {
+    std::swap_ranges(slots, slots + N, other.slots);
+    std::swap_ranges(slot_tree, slot_tree + N + 1, other.slot_tree);
+  }
+};
+//没有小数组 也不占地方
+template<class Ptr> struct chunk_slots<Ptr, 0>{
+  Ptr *small_map() { return nullptr; }
+  size_t *small_tree() { return nullptr; }
+  void swap_slots(chunk_slots &) {}
+};
+
+/**
+ * the chunk map of a deque: the chunk pointers stored contiguously with
+ * spare slots at both ends (like the block map of std::deque), plus a
+ * fenwick tree over the chunk sizes indexed by slot (ord), so the chunk
+ * holding the k-th element is found in O(log #chunks).
+ * adding or removing a chunk at the front or the back uses the spare
+ * slots and doesn't renumber the others; a chunk inserted or erased in the
+ * middle shifts the shorter side and rebuilds the tree.
+ * size changes of the first and the last chunk are only counted in
+ * front_pending / back_pending and written into the tree when that chunk
+ * stops being an end, so push and pop stay O(1).
+ * Ptr points to a chunk with size() and a writable ord.
+ * with SmallCap > 0 the map and the tree of up to SmallCap slots are kept
+ * in the object, so a few chunks need no allocation.
+ */
+template<class Ptr, size_t SmallCap = 0> class chunk_index : public chunk_slots<Ptr, SmallCap>{
+  public:
+    //块很少时用对象里的小数组 不用new
+    static constexpr size_t small_cap = SmallCap;
+    using chunk_slots<Ptr, SmallCap>::small_map;
+    using chunk_slots<Ptr, SmallCap>::small_tree;
+    size_t *tree;
+    Ptr *map;
+    size_t cap, lo, hi;
+    //可能是"负数" 按模2^64算
+    size_t front_pending, back_pending;
+    // --------------------------
+    chunk_index() : tree(nullptr), map(nullptr), cap(0), lo(0), hi(0), front_pending(0), back_pending(0) {}
+    chunk_index(const chunk_index &other) = delete;
+    chunk_index &operator=(const chunk_index &other) = delete;
+    ~chunk_index() { free_arrays(); }
+    void free_arrays() {
+      if(map == small_map())
+        return;
+      delete[] tree;
+      delete[] map;
+    }
+    size_t count() const { return hi - lo; }
+    Ptr front() const { return map[lo]; }
+    Ptr back() const { return map[hi - 1]; }
+    //两头再往外走就是nullptr
+    Ptr next(Ptr p) const { return p->ord + 1 < hi ? map[p->ord + 1] : nullptr; }
+    Ptr prev(Ptr p) const { return p->ord > lo ? map[p->ord - 1] : nullptr; }
+    static size_t spare_cap(size_t m) { return 2 * m + 8; }
+    /**
+     * build the tree again from the chunk sizes.
+     */
+    void rebuild() {
+      for(size_t j = 1; j <= cap; j++)
+        tree[j] = 0;
+      for(size_t j = 1; j <= cap; j++) {
+        if(j - 1 >= lo && j - 1 < hi)
+          tree[j] += map[j - 1]->size();
+        size_t up = j + (j & -j);
+        if(up <= cap)
+          tree[up] += tree[j];
+      }
+      front_pending = back_pending = 0;
+    }
+    /**
+     * move the chunks into a new array of new_cap slots (centered).
+     * the small arrays are used instead while both ends keep room free
+     * slots.
+     */
+    void layout(size_t new_cap, size_t room = 1) {
+      size_t m = count();
+      Ptr old[small_cap > 0 ? small_cap : 1];
+      bool small = m + 2 * room <= small_cap;
+      Ptr *new_map = small_map();
+      size_t *new_tree = small_tree();
+      if(small) {
+        //可能就是从小数组挪到小数组
+        std::copy(map + lo, map + hi, old);
+        new_cap = small_cap;
+      }else {
+        new_map = new Ptr[new_cap];
+        try {
+          new_tree = new size_t[new_cap + 1];
+        }catch(...) {
+          delete[] new_map;
+          throw;
+        }
+      }
+      size_t new_lo = (new_cap - m) / 2;
+      for(size_t i = 0; i < m; i++) {
+        new_map[new_lo + i] = small ? old[i] : map[lo + i];
+        new_map[new_lo + i]->ord = new_lo + i;
+      }
+      free_arrays();
+      map = new_map;
+      tree = new_tree;
+      cap = new_cap, lo = new_lo, hi = new_lo + m;
+      rebuild();
+    }
+    //两头都至少能再放k块
+    void reserve(size_t k) {
+      if(lo < k || cap - hi < k)
+        layout(spare_cap(count() + k), k);
+    }
+    //块本身由deque负责delete
+    void clear() {
+      free_arrays();
+      map = nullptr, tree = nullptr;
+      cap = lo = hi = 0;
+      front_pending = back_pending = 0;
+    }
+    void flush() {
+      if(front_pending)
+        tree_add(lo, front_pending);
+      if(back_pending)
+        tree_add(hi - 1, back_pending);
+      front_pending = back_pending = 0;
+    }
+    void push_back(Ptr p) {
+      flush();
+      if(hi == cap)
+        layout(spare_cap(count() + 1));
+      map[hi] = p;
+      p->ord = hi;
+      tree_add(hi++, p->size());
+    }
+    void push_front(Ptr p) {
+      flush();
+      if(lo == 0)
+        layout(spare_cap(count() + 1));
+      map[--lo] = p;
+      p->ord = lo;
+      tree_add(lo, p->size());
+    }
+    //去掉的块此时必须是空的
+    void pop_back() {
+      flush();
+      hi--;
+    }
+    void pop_front() {
+      flush();
+      lo++;
+    }
+    /**
+     * put p into slot ord, the chunks from ord on move back by one
+     * (or the ones before move forward, whichever side is shorter).
+     */
+    void insert(size_t ord, Ptr p) {
+      if(lo == 0 && hi == cap) {
+        size_t k = ord - lo;
+        layout(spare_cap(count() + 1));
+        ord = lo + k;
+      }
+      if(hi == cap || (lo > 0 && ord - lo < hi - ord)) {
+        for(size_t i = lo; i < ord; i++) {
+          map[i - 1] = map[i];
+          map[i - 1]->ord = i - 1;
+        }
+        lo--, ord--;
+      }else {
+        for(size_t i = hi; i > ord; i--) {
+          map[i] = map[i - 1];
+          map[i]->ord = i;
+        }
+        hi++;
+      }
+      map[ord] = p;
+      p->ord = ord;
+      rebuild();
+    }
+    /**
+     * take the chunks in slots [from, to) out of the map.
+     */
+    void erase(size_t from, size_t to) {
+      size_t m = to - from;
+      if(from - lo < hi - to) {
+        for(size_t i = from; i > lo; i--) {
+          map[i - 1 + m] = map[i - 1];
+          map[i - 1 + m]->ord = i - 1 + m;
+        }
+        lo += m;
+      }else {
+        for(size_t i = to; i < hi; i++) {
+          map[i - m] = map[i];
+          map[i - m]->ord = i - m;
+        }
+        hi -= m;
+      }
+      rebuild();
+    }
+    void erase(size_t ord) {
+      erase(ord, ord + 1);
+    }
+    void swap(chunk_index &other) {
+      bool mine = map == small_map(), theirs = other.map == other.small_map();
+      this->swap_slots(other);
+      std::swap(tree, other.tree);
+      std::swap(map, other.map);
+      std::swap(cap, other.cap);
+      std::swap(lo, other.lo);
+      std::swap(hi, other.hi);
+      std::swap(front_pending, other.front_pending);
+      std::swap(back_pending, other.back_pending);
+      //小数组换的是内容 指针要指回自己的
+      if(mine)
+        other.map = other.small_map(), other.tree = other.small_tree();
+      if(theirs)
+        map = small_map(), tree = small_tree();
+    }
+    /**
+     * move all the chunks of other into the slots from ord on (the chunks
+     * from ord on move back), other becomes empty.
+     */
+    void splice(size_t ord, chunk_index &other) {
+      size_t m = count() + other.count();
+      Ptr old[small_cap > 0 ? small_cap : 1];
+      bool small = m + 2 <= small_cap;
+      size_t new_cap = small ? small_cap : spare_cap(m);
+      Ptr *new_map = small_map();
+      size_t *new_tree = small_tree();
+      if(!small) {
+        new_map = new Ptr[new_cap];
+        try {
+          new_tree = new size_t[new_cap + 1];
+        }catch(...) {
+          delete[] new_map;
+          throw;
+        }
+      }
+      size_t new_lo = (new_cap - m) / 2, i = 0;
+      //小数组可能正是自己的 先排到old里
+      Ptr *to = small ? old : new_map + new_lo;
+      for(size_t j = lo; j < ord; j++)
+        to[i++] = map[j];
+      for(size_t j = other.lo; j < other.hi; j++)
+        to[i++] = other.map[j];
+      for(size_t j = ord; j < hi; j++)
+        to[i++] = map[j];
+      for(i = 0; i < m; i++) {
+        new_map[new_lo + i] = to[i];
+        new_map[new_lo + i]->ord = new_lo + i;
+      }
+      free_arrays();
+      map = new_map;
+      tree = new_tree;
+      cap = new_cap, lo = new_lo, hi = new_lo + m;
+      rebuild();
+      other.clear();
+    }
+    void front_grow() { front_pending++; }
+    void front_shrink() { front_pending--; }
+    void back_grow() { back_pending++; }
+    void back_shrink() { back_pending--; }
+    void tree_add(size_t ord, size_t delta) {
+      for(size_t i = ord + 1; i <= cap; i += i & -i)
+        tree[i] += delta;
+    }
+    //两端的块只记pending 树里的值不能变成负的
+    void add(size_t ord, size_t delta) {
+      if(ord == lo)
+        front_pending += delta;
+      else if(ord == hi - 1)
+        back_pending += delta;
+      else
+        tree_add(ord, delta);
+    }
+    void sub(size_t ord, size_t delta) { add(ord, size_t(0) - delta); }
+    /**
+     * the number of elements in the chunks before slot ord.
+     */
+    size_t prefix(size_t ord) const {
+      size_t ans = 0;
+      for(size_t i = ord; i > 0; i -= i & -i)
+        ans += tree[i];
+      if(ord > lo)
+        ans += front_pending;
+      if(ord >= hi)
+        ans += back_pending;
+      return ans;
+    }
+    /**
+     * the slot of the chunk holding the pos-th element (of total),
+     * pos becomes the index inside that chunk.
+     */
+    size_t locate(size_t &pos, size_t total) const {
+      size_t front_s = map[lo]->size(), back_s = map[hi - 1]->size();
+      if(pos < front_s)
+        return lo;
+      if(pos >= total - back_s) {
+        pos -= total - back_s;
+        return hi - 1;
+      }
+      //中间的块在树里都是准的
+      pos -= front_pending;
+      size_t i = 0, step = 1;
+      while(step * 2 <= cap)
+        step <<= 1;
+      for(; step > 0; step >>= 1) {
+        if(i + step <= cap && tree[i + step] <= pos) {
+          i += step;
+          pos -= tree[i];
+        }
+      }
+      return i;
+    }
+};
+
+//floor(sqrt(n)) + 1 只在n跨过完全平方数时才变 不用开方
+struct sqrt_root {
+  size_t root;
+  sqrt_root() : root(1) {}
+  //变了才返回true
+  bool step(size_t n) {
+    if(root * root > n && (root - 1) * (root - 1) <= n)
+      return false;
+    while(root * root <= n)
+      root++;
+    while((root - 1) * (root - 1) > n)
+      root--;
+    return true;
+  }
+  static size_t of(size_t n) { return size_t(floor(sqrt(n))) + 1; }
+};
+
+/**
+ * the chunk length policies of deque (its third template argument).
+ * target is the length of a new chunk, a chunk longer than split is cut
+ * in two and one shorter than merge joins a neighbour; resize(n) is
+ * called whenever the size becomes n and target_for(n) is the target at
+ * size n. a deque of at most small elements keeps them in one chunk.
+ * local_bytes is the room for elements the deque keeps in itself (see
+ * deque::local), 0 for all but local_policy.
+ *
+ * sqrt_policy: target sqrt(n), split above 1.5 times and merge below 0.5
+ * times of it; small is 16.
+ */
+struct sqrt_policy {
+  static constexpr size_t local_bytes = 0;
+  sqrt_root r;
+  size_t target, split, merge, small;
+  explicit sqrt_policy(size_t) : small(16) { set(); }
+  void set() {
+    target = r.root;
+    split = target + target / 2;
+    merge = (target + 1) / 2;
+  }
+  void resize(size_t n) {
+    if(r.step(n))
+      set();
+  }
+  size_t target_for(size_t n) const { return sqrt_root::of(n); }
+};
+
+/**
+ * a fixed chunk length of Bytes / sizeof(T) elements (at least one),
+ * whatever the size of the deque.
+ */
+template<size_t Bytes = 4096> struct fixed_bytes_policy {
+  static constexpr size_t local_bytes = 0;
+  size_t target, split, merge, small;
+  explicit fixed_bytes_policy(size_t elem_size) {
+    target = Bytes / elem_size > 0 ? Bytes / elem_size : 1;
+    split = target + target / 2;
+    merge = (target + 1) / 2;
+    small = target;
+  }
+  void resize(size_t) {}
+  size_t target_for(size_t) const { return target; }
+};
+
+/**
+ * like sqrt_policy, but the target is rounded up so a full chunk takes a
+ * whole number of Align-byte units (cache lines, pages); so is small.
+ */
+template<size_t Align> struct aligned_policy {
+  static constexpr size_t local_bytes = 0;
+  sqrt_root r;
+  size_t elem_size, target, split, merge, small;
+  explicit aligned_policy(size_t elem_size_) : elem_size(elem_size_) {
+    set();
+    small = round(16);
+  }
+  size_t round(size_t t) const {
+    size_t bytes = (t * elem_size + Align - 1) / Align * Align;
+    return bytes / elem_size > 0 ? bytes / elem_size : 1;
+  }
+  void set() {
+    target = round(r.root);
+    split = target + target / 2;
+    merge = (target + 1) / 2;
+  }
+  void resize(size_t n) {
+    if(r.step(n))
+      set();
+  }
+  size_t target_for(size_t n) const { return round(sqrt_root::of(n)); }
+};
+
+/**
+ * Base, plus room for Bytes of elements (one cache line by default) inside
+ * the deque object, so a deque that small allocates nothing. only
+ * circular_array chunks use it:
+ *   sjtu::deque<int, sjtu::circular_array<int>, sjtu::local_policy<>>
+ */
+template<class Base = sqrt_policy, size_t Bytes = 64> struct local_policy : Base {
+  static constexpr size_t local_bytes = Bytes;
+  explicit local_policy(size_t elem_size) : Base(elem_size) {}
+};
+using cache_line_policy = aligned_policy<64>;
+using page_policy = aligned_policy<4096>;
+
+/**
+ * scans over contiguous spans of arithmetic values (the chunks of
+ * circular_array): find, count, equal, min and max.
+ * they use AVX2 or SSE2 (SSE4.1 for min / max) when the compiler targets
+ * them and a plain loop otherwise; has_kernel<T> tells whether T gets the
+ * vector version. define SJTU_NO_SIMD to always use the plain loops.
+ * min / max are vectorised for integers of up to 32 bits only, floating
+ * point ones stay scalar so that NaN behaves as in std::min_element.
+ */
+namespace simd {
+
+#if defined(SJTU_NO_SIMD)
+constexpr size_t width = 0;
+#elif defined(__AVX2__)
+constexpr size_t width = 32;
+using reg = __m256i;
+inline reg load(const void *p) { return _mm256_loadu_si256(static_cast<const reg*>(p)); }
+inline unsigned bits(reg a) { return unsigned(_mm256_movemask_epi8(a)); }
+template<class T> inline reg splat(T v) {
+  if(std::is_same<T, float>::value)
+    return _mm256_castps_si256(_mm256_set1_ps(float(v)));
+  if(std::is_same<T, double>::value)
+    return _mm256_castpd_si256(_mm256_set1_pd(double(v)));
+  if(sizeof(T) == 1)
+    return _mm256_set1_epi8(char(v));
+  if(sizeof(T) == 2)
+    return _mm256_set1_epi16(short(v));
+  if(sizeof(T) == 4)
+    return _mm256_set1_epi32(int(v));
+  return _mm256_set1_epi64x((long long)(v));
+}
+//相等的那几条lane全是1
+template<class T> inline reg eq(reg a, reg b) {
+  if(std::is_same<T, float>::value)
+    return _mm256_castps_si256(_mm256_cmp_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b), _CMP_EQ_OQ));
+  if(std::is_same<T, double>::value)
+    return _mm256_castpd_si256(_mm256_cmp_pd(_mm256_castsi256_pd(a), _mm256_castsi256_pd(b), _CMP_EQ_OQ));
+  if(sizeof(T) == 1)
+    return _mm256_cmpeq_epi8(a, b);
+  if(sizeof(T) == 2)
+    return _mm256_cmpeq_epi16(a, b);
+  if(sizeof(T) == 4)
+    return _mm256_cmpeq_epi32(a, b);
+  return _mm256_cmpeq_epi64(a, b);
+}
+template<class T> inline reg vmin(reg a, reg b) {
+  if(sizeof(T) == 1)
+    return std::is_signed<T>::value ? _mm256_min_epi8(a, b) : _mm256_min_epu8(a, b);
+  if(sizeof(T) == 2)
+    return std::is_signed<T>::value ? _mm256_min_epi16(a, b) : _mm256_min_epu16(a, b);
+  return std::is_signed<T>::value ? _mm256_min_epi32(a, b) : _mm256_min_epu32(a, b);
+}
+template<class T> inline reg vmax(reg a, reg b) {
+  if(sizeof(T) == 1)
+    return std::is_signed<T>::value ? _mm256_max_epi8(a, b) : _mm256_max_epu8(a, b);
+  if(sizeof(T) == 2)
+    return std::is_signed<T>::value ? _mm256_max_epi16(a, b) : _mm256_max_epu16(a, b);
+  return std::is_signed<T>::value ? _mm256_max_epi32(a, b) : _mm256_max_epu32(a, b);
+}
+#define SJTU_SIMD_MINMAX 1
+#elif defined(__SSE2__)
+constexpr size_t width = 16;
+using reg = __m128i;
+inline reg load(const void *p) { return _mm_loadu_si128(static_cast<const reg*>(p)); }
+inline unsigned bits(reg a) { return unsigned(_mm_movemask_epi8(a)); }
+template<class T> inline reg splat(T v) {
+  if(std::is_same<T, float>::value)
+    return _mm_castps_si128(_mm_set1_ps(float(v)));
+  if(std::is_same<T, double>::value)
+    return _mm_castpd_si128(_mm_set1_pd(double(v)));
+  if(sizeof(T) == 1)
+    return _mm_set1_epi8(char(v));
+  if(sizeof(T) == 2)
+    return _mm_set1_epi16(short(v));
+  if(sizeof(T) == 4)
+    return _mm_set1_epi32(int(v));
+  return _mm_set1_epi64x((long long)(v));
+}
+template<class T> inline reg eq(reg a, reg b) {
+  if(std::is_same<T, float>::value)
+    return _mm_castps_si128(_mm_cmpeq_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b)));
+  if(std::is_same<T, double>::value)
+    return _mm_castpd_si128(_mm_cmpeq_pd(_mm_castsi128_pd(a), _mm_castsi128_pd(b)));
+  if(sizeof(T) == 1)
+    return _mm_cmpeq_epi8(a, b);
+  if(sizeof(T) == 2)
+    return _mm_cmpeq_epi16(a, b);
+  reg t = _mm_cmpeq_epi32(a, b);
+  if(sizeof(T) == 4)
+    return t;
+  //SSE2没有64位的比较 两半都相等才算
+  return _mm_and_si128(t, _mm_shuffle_epi32(t, _MM_SHUFFLE(2, 3, 0, 1)));
+}
+#if defined(__SSE4_1__)
+template<class T> inline reg vmin(reg a, reg b) {
+  if(sizeof(T) == 1)
+    return std::is_signed<T>::value ? _mm_min_epi8(a, b) : _mm_min_epu8(a, b);
+  if(sizeof(T) == 2)
+    return std::is_signed<T>::value ? _mm_min_epi16(a, b) : _mm_min_epu16(a, b);
+  return std::is_signed<T>::value ? _mm_min_epi32(a, b) : _mm_min_epu32(a, b);
+}
+template<class T> inline reg vmax(reg a, reg b) {
+  if(sizeof(T) == 1)
+    return std::is_signed<T>::value ? _mm_max_epi8(a, b) : _mm_max_epu8(a, b);
+  if(sizeof(T) == 2)
+    return std::is_signed<T>::value ? _mm_max_epi16(a, b) : _mm_max_epu16(a, b);
+  return std::is_signed<T>::value ? _mm_max_epi32(a, b) : _mm_max_epu32(a, b);
+}
+#define SJTU_SIMD_MINMAX 1
+#endif
+#else
+constexpr size_t width = 0;
+#endif
+
+template<class T> struct has_kernel : std::integral_constant<bool,
+  width != 0 && std::is_arithmetic<T>::value && std::is_trivially_copyable<T>::value && !std::is_same<T, bool>::value &&
+  (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8)> {};
+template<class T> struct has_minmax : std::integral_constant<bool,
+#if defined(SJTU_SIMD_MINMAX)
+  has_kernel<T>::value && std::is_integral<T>::value && sizeof(T) <= 4
+#else
+  false
+#endif
+  > {};
+
+/**
+ * the first element equal to v in [b, e), e if there is none.
+ */
+template<class T> const T *find(const T *b, const T *e, T v, std::false_type) {
+  for(; b != e; ++b)
+    if(*b == v)
+      return b;
+  return e;
+}
+template<class T> size_t count(const T *b, const T *e, T v, std::false_type) {
+  size_t ans = 0;
+  for(; b != e; ++b)
+    ans += *b == v;
+  return ans;
+}
+template<class T> bool equal(const T *a, const T *b, size_t n, std::false_type) {
+  for(size_t i = 0; i < n; i++)
+    if(!(a[i] == b[i]))
+      return false;
+  return true;
+}
+//找第一个最小的 [b, e)不能为空
+template<class T> const T *min(const T *b, const T *e, std::false_type) {
+  const T *ans = b;
+  for(++b; b < e; ++b)
+    if(*b < *ans)
+      ans = b;
+  return ans;
+}
+template<class T> const T *max(const T *b, const T *e, std::false_type) {
+  const T *ans = b;
+  for(++b; b < e; ++b)
+    if(*ans < *b)
+      ans = b;
+  return ans;
+}
+#if !defined(SJTU_NO_SIMD) && (defined(__AVX2__) || defined(__SSE2__))
+constexpr size_t unit = width;
+template<class T> const T *find(const T *b, const T *e, T v, std::true_type) {
+  const size_t per = unit / sizeof(T);
+  reg x = splat<T>(v);
+  for(; size_t(e - b) >= per; b += per) {
+    unsigned m = bits(eq<T>(load(b), x));
+    if(m)
+      return b + __builtin_ctz(m) / sizeof(T);
+  }
+  return simd::find(b, e, v, std::false_type());
+}
+template<class T> size_t count(const T *b, const T *e, T v, std::true_type) {
+  const size_t per = unit / sizeof(T);
+  reg x = splat<T>(v);
+  size_t ans = 0;
+  for(; size_t(e - b) >= per; b += per)
+    ans += __builtin_popcount(bits(eq<T>(load(b), x)));
+  return ans / sizeof(T) + simd::count(b, e, v, std::false_type());
+}
+template<class T> bool equal(const T *a, const T *b, size_t n, std::true_type) {
+  const size_t per = unit / sizeof(T);
+  const unsigned all = unsigned((1ull << unit) - 1);
+  size_t i = 0;
+  for(; i + per <= n; i += per)
+    if(bits(eq<T>(load(a + i), load(b + i))) != all)
+      return false;
+  return simd::equal(a + i, b + i, n - i, std::false_type());
+}
+#endif
+#if defined(SJTU_SIMD_MINMAX)
+//先算出最小值 再找它第一次出现的位置
+template<class T> const T *min(const T *b, const T *e, std::true_type) {
+  const size_t per = unit / sizeof(T);
+  if(size_t(e - b) < per)
+    return simd::min(b, e, std::false_type());
+  reg acc = load(b);
+  const T *p = b + per;
+  for(; size_t(e - p) >= per; p += per)
+    acc = vmin<T>(acc, load(p));
+  T lane[unit / sizeof(T)];
+  __builtin_memcpy(lane, &acc, unit);
+  T m = *simd::min(lane, lane + per, std::false_type());
+  for(; p != e; ++p)
+    if(*p < m)
+      m = *p;
+  return simd::find(b, e, m, std::true_type());
+}
+template<class T> const T *max(const T *b, const T *e, std::true_type) {
+  const size_t per = unit / sizeof(T);
+  if(size_t(e - b) < per)
+    return simd::max(b, e, std::false_type());
+  reg acc = load(b);
+  const T *p = b + per;
+  for(; size_t(e - p) >= per; p += per)
+    acc = vmax<T>(acc, load(p));
+  T lane[unit / sizeof(T)];
+  __builtin_memcpy(lane, &acc, unit);
+  T m = *simd::max(lane, lane + per, std::false_type());
+  for(; p != e; ++p)
+    if(m < *p)
+      m = *p;
+  return simd::find(b, e, m, std::true_type());
+}
+#endif
+template<class T> const T *find(const T *b, const T *e, T v) { return simd::find(b, e, v, has_kernel<T>()); }
+template<class T> size_t count(const T *b, const T *e, T v) { return simd::count(b, e, v, has_kernel<T>()); }
+template<class T> bool equal(const T *a, const T *b, size_t n) { return simd::equal(a, b, n, has_kernel<T>()); }
+template<class T> const T *min(const T *b, const T *e) { return simd::min(b, e, has_minmax<T>()); }
+template<class T> const T *max(const T *b, const T *e) { return simd::max(b, e, has_minmax<T>()); }
+
+} // namespace simd
+
+template <class T, class Chunk = double_list<T>, class Policy = sqrt_policy> class deque {
+public:
+  using pool_type = typename Chunk::pool_type;
+  /**
+   * the elements of a block. snapshots of a deque share them, refs counts
+   * the blocks pointing here.
+   */
+  struct shared_chunk : public Chunk {
+    std::atomic<size_t> refs;
+    //复制出这块的那块(占它一个引用) 复制之前取的迭代器在那里数出自己的位置
+    shared_chunk *origin;
+    explicit shared_chunk(pool_type *pool_) : Chunk(pool_), refs(1), origin(nullptr) {}
+    //deque对象里那块用的 见local
+    template<class Space> explicit shared_chunk(Space &space) : Chunk(space), refs(1), origin(nullptr) {}
+    //只拷贝元素 refs不变
+    shared_chunk &operator=(const shared_chunk &other) {
+      Chunk::operator=(other);
+      return *this;
+    }
+    //只在refs为1时调 共用的块别的线程可能正在读origin
+    void forget() {
+      if(origin)
+        drop(origin);
+      origin = nullptr;
+    }
+    static void drop(shared_chunk *c) {
+      if(--c->refs == 0) {
+        c->forget();
+        delete c;
+      }
+    }
+  };
+  /**
+   * a slot in the chunk map: the chunk, and where it is in the map.
+   * every deque has its own blocks, only the chunks are shared.
+   * an emptied block kept for reuse is chained by next_spare instead.
+   */
+  struct block {
+    size_t ord;
+    shared_chunk *chunk;
+    block *next_spare;
+    //deque::local 没在用的时候chunk是nullptr
+    block() : ord(0), chunk(nullptr), next_spare(nullptr) {}
+    explicit block(pool_type *pool_) : ord(0), chunk(new shared_chunk(pool_)), next_spare(nullptr) {}
+    //只加一个引用 origin留给refs回到1的那边(own/retire)放掉
+    explicit block(shared_chunk *chunk_) : ord(0), chunk(chunk_), next_spare(nullptr) {
+      chunk->refs++;
+    }
+    block(const block &other) = delete;
+    block &operator=(const block &other) = delete;
+    ~block() {
+      if(chunk)
+        shared_chunk::drop(chunk);
+    }
+    size_t size() const { return chunk->size(); }
+  };
+  using chunk_it_type = typename Chunk::iterator;
+  using block_it_type = block *;
+
+public:
+  //所有块共用一个pool 块之间挪节点也没有问题
+  pool_type *pool;
+  size_t sum_s;
+  //块长怎么定由Policy决定
+  Policy sizing;
+  /**
+   * blocks emptied by pop_* are kept (spare_n of them, chained from spare)
+   * and reopened by the next push, so a queue going back and forth over a
+   * chunk boundary doesn't allocate and free a chunk every time. above
+   * spare_high kept blocks the list is cut to spare_low; reserve() raises
+   * both to spare_floor.
+   */
+  static constexpr size_t spare_high = 4, spare_low = 2;
+  block_it_type spare;
+  size_t spare_n, spare_floor;
+  /**
+   * only with a Policy asking for it (local_bytes, see local_policy) and a
+   * chunk able to use outside storage (circular_array), the first block is
+   * built inside the deque: the block, its chunk and room for local_n
+   * elements, at most local_bytes of them. a deque of up to local_n
+   * elements then allocates nothing, new_block() takes it when no spare
+   * block is kept. it is never shared with a snapshot nor handed to
+   * another deque: snapshot copies its elements, split_at / append move
+   * them into a block of the receiver, swap / move first move them to a
+   * block on the heap (spill). otherwise local_n is 0 and none of it is in
+   * the object.
+   */
+  static constexpr size_t local_fit(size_t n) {
+    return 2 * n * sizeof(T) <= Policy::local_bytes ? local_fit(2 * n) : n;
+  }
+  static constexpr size_t local_n = Chunk::local_storage && sizeof(T) <= Policy::local_bytes ? local_fit(1) : 0;
+  template<size_t N, bool = (N > 0)> struct local_store{
+    typename Chunk::template local_space<N> space;
+    alignas(shared_chunk) unsigned char bytes[sizeof(shared_chunk)];
+    block b;
+    bool holds(const block *p) const { return p == &b; }
+    //在用的话返回这块
+    block *used() { return b.chunk ? &b : nullptr; }
+    //没在用的话建好chunk返回这块
+    block *open() {
+      if(b.chunk)
+        return nullptr;
+      b.chunk = new (bytes) shared_chunk(space);
+      return &b;
+    }
+    void close() {
+      b.chunk->~shared_chunk();
+      b.chunk = nullptr;
+    }
+  };
+  template<size_t N> struct local_store<N, false>{
+    bool holds(const block *) const { return false; }
+    block *used() { return nullptr; }
+    block *open() { return nullptr; }
+    void close() {}
+  };
+  //块指针连续存放 两头留空位 对象里有块时块少也放在自带的小数组里
+  using index_type = chunk_index<block *, (local_n > 0 ? 4 : 0)>;
+  index_type index;
+  //拍过快照以后块可能和别的deque共用 写之前要先own
+  //几个线程可以同时对同一个deque调snapshot() 所以是atomic
+  mutable std::atomic<bool> shares;
+  //放在最后 不夹在每次都用的字段中间 没有的时候占的是shares后面的空
+  local_store<local_n> local;
+  class const_iterator;
+  //没超过sizing.small就一直用一块 块长多少由Policy定
+  size_t standard_size() const {
+    return sum_s < sizing.small ? sizing.small : sizing.target;
+  }
+  size_t standard_size(size_t n) const {
+    return n <= sizing.small ? sizing.small : sizing.target_for(n);
+  }
+  size_t split_size() const {
+    return sum_s <= sizing.small ? sizing.small : sizing.split;
+  }
+  //sum_s变了之后调用
+  void fix_chunk_s() {
+    sizing.resize(sum_s);
+  }
+  //------------------------------
+  class iterator {
+  public:
+    //sjtu::for_each等分段算法靠它认出deque的迭代器
+    using deque_type = deque;
+    //有了这些std::sort等标准算法也能用
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+    deque *dq_it;
+    block_it_type block_it;
+    //块被复制出来之后要跟着挪过去
+    mutable chunk_it_type chunk_it;
+    //--------------------------
+    iterator() : dq_it(nullptr), block_it(), chunk_it(){}
+    iterator(deque* dq_it_, const block_it_type& block_it_, const chunk_it_type &chunk_it_) : dq_it(dq_it_), block_it(block_it_), chunk_it(chunk_it_){} 
+    /**
+     * if the chunk of block_it was cloned (see deque::own) since chunk_it
+     * was taken, move chunk_it to the same element in the new chunk. its
+     * position is counted in the old chunk while the clone still holds
+     * it, the cached index is used only when it has been let go.
+     */
+    void sync() const {
+      if(block_it && chunk_it.current_list != block_it->chunk)
+        chunk_it = block_it->chunk->nth(dq_it->position(block_it, chunk_it));
+    }
+    /**
+     * return a new iterator which points to the n-next element.
+     * if there are not enough elements, the behaviour is undefined.
+     * same for operator-.
+     */
+    iterator operator+(const int &n) const {
+      if(*this == iterator())
+        throw invalid_iterator();
+      if(n == 0)
+        return *this;
+      if(n < 0)
+        return (*this) - (-n);
+      // 注意这里是可以--end()的 所以对end的判断要写在这个之后
+      if(block_it == nullptr)
+        throw index_out_of_bound();
+      int n_ = n;
+      sync();
+      chunk_it_type chunk_it_ = block_it->chunk->step_forward(chunk_it, n_);
+      if(n_ == 0)
+        return iterator(dq_it, block_it, chunk_it_);
+      block_it_type block_it_ = dq_it->index.next(block_it);
+      if(block_it_ && size_t(n_) <= block_it_->chunk->size())
+        return iterator(dq_it, block_it_, block_it_->chunk->nth(n_ - 1));
+      //下一块也不够 剩下的用下标直接找
+      size_t pos = dq_it->index.prefix(block_it->ord + 1) - 1 + n_;
+      if(pos > dq_it->sum_s)
+        throw index_out_of_bound();
+      auto found = dq_it->locate(pos);
+      return iterator(dq_it, found.first, found.second);
+    }
+    iterator operator-(const int &n) const {
+      if(*this == iterator())
+        throw invalid_iterator(); //指向begin的之后未必直接throw
+      if(n == 0)
+        return *this;
+      else if(n < 0)
+        return (*this) + (-n);
+      int n_ = n;
+      size_t pos = dq_it->sum_s;
+      if(block_it != nullptr) {
+        sync();
+        chunk_it_type chunk_it_ = block_it->chunk->step_backward(chunk_it, n_);
+        if(n_ == 0)
+          return iterator(dq_it, block_it, chunk_it_);
+        pos = dq_it->index.prefix(block_it->ord);
+      }
+      //end的前一块是最后一块
+      block_it_type block_it_ = block_it ? dq_it->index.prev(block_it) : (dq_it->index.count() ? dq_it->index.back() : nullptr);
+      if(block_it_) {
+        if(size_t(n_) <= block_it_->chunk->size())
+          return iterator(dq_it, block_it_, block_it_->chunk->nth(block_it_->chunk->size() - n_));
+      }
+      if(size_t(n_) > pos)
+        throw index_out_of_bound();
+      auto found = dq_it->locate(pos - n_);
+      return iterator(dq_it, found.first, found.second);
+    }
+    /**
+     * return the distance between two iterators.
+     * if they point to different vectors, throw
+     * invaild_iterator.
+     */
+    int operator-(const iterator &rhs) const {
+      if(dq_it != rhs.dq_it)
+        throw invalid_iterator();
+      sync();
+      rhs.sync();
+      if(block_it == rhs.block_it) {
+        if(block_it == nullptr)
+          return 0;
+        return static_cast<int>(Chunk::init_size(*this->block_it->chunk, this->chunk_it)) - Chunk::init_size(*rhs.block_it->chunk, rhs.chunk_it);
+      }
+      //块的前缀和直接从树状数组里查
+      return static_cast<int>(dq_it->init_size(block_it, chunk_it)) - static_cast<int>(dq_it->init_size(rhs.block_it, rhs.chunk_it));
+    }
+    /**
+     * compare the positions of two iterators of the same deque.
+     * iterators in different chunks are ordered by the chunk ord alone.
+     */
+    bool operator<(const iterator &rhs) const {
+      if(dq_it != rhs.dq_it)
+        throw invalid_iterator();
+      if(block_it != rhs.block_it)
+        return dq_it->rank(block_it) < dq_it->rank(rhs.block_it);
+      return *this - rhs < 0;
+    }
+    bool operator>(const iterator &rhs) const {
+      return rhs < *this;
+    }
+    bool operator<=(const iterator &rhs) const {
+      return !(rhs < *this);
+    }
+    bool operator>=(const iterator &rhs) const {
+      return !(*this < rhs);
+    }
+    iterator &operator+=(const int &n) {
+      return *this = *this + n;
+    }
+    iterator &operator-=(const int &n) {
+      return *this = *this - n;
+    }
+    T &operator[](const int &n) const {
+      return *(*this + n);
+    }
+
+    /**
+     * iter++
+     */
+    iterator operator++(int) {
+      iterator old = *this;
+      *this = *this + 1;
+      return old;
+    }
+    /**
+     * ++iter
+     */
+    iterator &operator++() {
+      //还在块内就直接走
+      if(block_it) {
+        sync();
+        chunk_it_type next = chunk_it;
+        if(++next != block_it->chunk->end()) {
+          chunk_it = next;
+          return *this;
+        }
+      }
+      return *this = *this + 1;
+    }
+    /**
+     * iter--
+     */
+    iterator operator--(int) {
+      iterator old = *this;
+      *this = *this - 1;
+      return old;
+    }
+    /**
+     * --iter
+     */
+    iterator &operator--() {
+      return *this = *this - 1;
+    }
+
+    /**
+     * *it
+     */
+    T &operator*() const {
+      dq_it->own(*this, true);
+      return *chunk_it;
+    }
+    /**
+     * it->field
+     */
+    T *operator->() const {
+      dq_it->own(*this, true);
+      return chunk_it.operator->();
+    }
+
+    /**
+     * check whether two iterators are the same (pointing to the same
+     * memory).
+     */
+    bool operator==(const iterator &rhs) const {
+      sync();
+      rhs.sync();
+      if(dq_it == rhs.dq_it && block_it == rhs.block_it && chunk_it == rhs.chunk_it)
+        return true;
+      return false;
+    }
+    bool operator==(const const_iterator &rhs) const {
+      sync();
+      rhs.sync();
+      if(dq_it == rhs.dq_it && block_it == rhs.block_it && chunk_it == rhs.chunk_it)
+        return true;
+      return false;
+    }
+    /**
+     * some other operator for iterators.
+     */
+    bool operator!=(const iterator &rhs) const {
+      return !(*this == rhs);
+    }
+    bool operator!=(const const_iterator &rhs) const {
+      return !(*this == rhs);
+    }
+  };
+
+  class const_iterator {
+    /**
+     * it should has similar member method as iterator.
+     * you can copy them, but with care!
+     * and it should be able to be constructed from an iterator.
+     */
+   public:
+    using deque_type = deque;
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+    const deque *dq_it;
+    block_it_type block_it;
+    mutable chunk_it_type chunk_it;
+    //--------------------------
+    const_iterator() : dq_it(nullptr), block_it(), chunk_it(){}
+    const_iterator(const deque *dq_it_, const block_it_type block_it_, const chunk_it_type chunk_it_) : dq_it(dq_it_), block_it(block_it_), chunk_it(chunk_it_){} 
+    const_iterator(const iterator &other) : dq_it(other.dq_it), block_it(other.block_it), chunk_it(other.chunk_it){}
+    //同iterator::sync
+    void sync() const {
+      if(block_it && chunk_it.current_list != block_it->chunk)
+        chunk_it = block_it->chunk->nth(dq_it->position(block_it, chunk_it));
+    }
+    /**
+     * return a new iterator which points to the n-next element.
      * if there are not enough elements, the behaviour is undefined.
      * same for operator-.
      */
@@ -557,35 +2176,19 @@ public:
       if(*this == dq_it->end())
         throw index_out_of_bound();
       int n_ = n;
-      list_it_type list_it_ = list_it;
-      chunk_it_type chunk_it_ = chunk_it;
-      while(chunk_it_ != --(list_it_->end()) && n_ > 0) {
-        chunk_it_++;
-        n_--;
-      }
+      sync();
+      chunk_it_type chunk_it_ = block_it->chunk->step_forward(chunk_it, n_);
       if(n_ == 0)
-        return const_iterator(dq_it, list_it_, chunk_it_);
-      if(list_it_ == --(dq_it->data.end())) {
-        if(n_ != 1)
-          throw index_out_of_bound();
-        else
-          return (dq_it)->cend();
-      } else 
-        list_it_++;
-      while(list_it_ != (dq_it->data.end()) && n_ > list_it_->size()) {
-        n_ -= list_it_->size();
-        list_it_++;
-      }
-      if(list_it_ == (dq_it->data.end())) {
-        if(n_ > 1)
-          throw index_out_of_bound();
-        else
-          return (dq_it)->cend();
-      }
-      chunk_it_ = list_it_->begin();
-      for (int i = 0; i < n_ - 1; i++)
-        chunk_it_++;
-      return const_iterator(dq_it, list_it_, chunk_it_);
+        return const_iterator(dq_it, block_it, chunk_it_);
+      block_it_type block_it_ = dq_it->index.next(block_it);
+      if(block_it_ && size_t(n_) <= block_it_->chunk->size())
+        return const_iterator(dq_it, block_it_, block_it_->chunk->nth(n_ - 1));
+      //下一块也不够 剩下的用下标直接找
+      size_t pos = dq_it->index.prefix(block_it->ord + 1) - 1 + n_;
+      if(pos > dq_it->sum_s)
+        throw index_out_of_bound();
+      auto found = dq_it->locate(pos);
+      return const_iterator(dq_it, found.first, found.second);
     }
     const_iterator operator-(const int &n) const {
       if(*this == iterator())
@@ -595,31 +2198,24 @@ public:
       else if(n < 0)
         return (*this) + (-n);
       int n_ = n;
-      list_it_type list_it_ = list_it;
-      chunk_it_type chunk_it_ = chunk_it;
-      if(*this == dq_it->end()) {
-        list_it_--;
-      }else {
-        while(n_ > 0 && chunk_it_ != list_it_->begin()) {
-          n_--;
-          chunk_it_--;
-        }
+      size_t pos = dq_it->sum_s;
+      if(*this != dq_it->end()) {
+        sync();
+        chunk_it_type chunk_it_ = block_it->chunk->step_backward(chunk_it, n_);
         if(n_ == 0)
-          return const_iterator(dq_it, list_it_, chunk_it_);
-        if(list_it_ == (dq_it->data.begin())) 
-          throw index_out_of_bound();
-        list_it_--;
+          return const_iterator(dq_it, block_it, chunk_it_);
+        pos = dq_it->index.prefix(block_it->ord);
       }
-      while(n_ > (int)list_it_->size() && list_it_ != dq_it->data.begin()) {
-        n_ -= list_it_->size();
-        list_it_--;
+      //end的前一块是最后一块
+      block_it_type block_it_ = block_it ? dq_it->index.prev(block_it) : (dq_it->index.count() ? dq_it->index.back() : nullptr);
+      if(block_it_) {
+        if(size_t(n_) <= block_it_->chunk->size())
+          return const_iterator(dq_it, block_it_, block_it_->chunk->nth(block_it_->chunk->size() - n_));
       }
-      if (n_ > list_it_->size())
+      if(size_t(n_) > pos)
         throw index_out_of_bound();
-      chunk_it_ = list_it_->begin();
-      for(int i = 0; i < list_it_->size() - n_; i++)
-        chunk_it_++;
-      return const_iterator(dq_it, list_it_, chunk_it_);
+      auto found = dq_it->locate(pos - n_);
+      return const_iterator(dq_it, found.first, found.second);
     }
     /**
      * return the distance between two iterators.
@@ -629,32 +2225,35 @@ public:
     int operator-(const const_iterator &rhs) const {
       if(dq_it != rhs.dq_it)
         throw invalid_iterator();
-      if(list_it == rhs.list_it) {
-        if(list_it == dq_it->data.end())
+      sync();
+      rhs.sync();
+      if(block_it == rhs.block_it) {
+        if(block_it == nullptr)
           return 0;
-        return static_cast<int>(double_list<T>::init_size(*(this->list_it), this->chunk_it)) - double_list<T>::init_size(*(rhs.list_it), rhs.chunk_it);
-      }
-      bool greater = double_list<double_list<T>>::init_size(dq_it->data, this->list_it) > double_list<double_list<T>>::init_size(dq_it->data, rhs.list_it);
-      list_it_type list_it_front = this->list_it, list_it_back = rhs.list_it;
-      chunk_it_type chunk_it_front = this->chunk_it, chunk_it_back = rhs.chunk_it;
-      if(greater) {
-        std::swap(list_it_front, list_it_back);
-        std::swap(chunk_it_front, chunk_it_back);
-      }
-      int res = static_cast<int>(list_it_front->size()) - double_list<T>::init_size(*list_it_front, chunk_it_front);
-      if(list_it_back != dq_it->data.end())
-        res += double_list<T>::init_size(*list_it_back, chunk_it_back);
-      else
-        res += 0;
-      ++list_it_front;
-      while(list_it_front != list_it_back) {
-        res += list_it_front->size();
-        list_it_front++;
-      }
-      if(greater)
-        return res;
-      else
-        return -res;
+        return static_cast<int>(Chunk::init_size(*this->block_it->chunk, this->chunk_it)) - Chunk::init_size(*rhs.block_it->chunk, rhs.chunk_it);
+      }
+      //块的前缀和直接从树状数组里查
+      return static_cast<int>(dq_it->init_size(block_it, chunk_it)) - static_cast<int>(dq_it->init_size(rhs.block_it, rhs.chunk_it));
+    }
+    /**
+     * compare the positions of two iterators of the same deque.
+     * iterators in different chunks are ordered by the chunk ord alone.
+     */
+    bool operator<(const const_iterator &rhs) const {
+      if(dq_it != rhs.dq_it)
+        throw invalid_iterator();
+      if(block_it != rhs.block_it)
+        return dq_it->rank(block_it) < dq_it->rank(rhs.block_it);
+      return *this - rhs < 0;
+    }
+    bool operator>(const const_iterator &rhs) const {
+      return rhs < *this;
+    }
+    bool operator<=(const const_iterator &rhs) const {
+      return !(rhs < *this);
+    }
+    bool operator>=(const const_iterator &rhs) const {
+      return !(*this < rhs);
     }
     const_iterator &operator+=(const int &n) {
       return *this = *this + n;
@@ -662,6 +2261,9 @@ public:
     const_iterator &operator-=(const int &n) {
       return *this = *this - n;
     }
+    const T &operator[](const int &n) const {
+      return *(*this + n);
+    }
 
     /**
      * iter++
@@ -675,6 +2277,15 @@ public:
      * ++iter
      */
     const_iterator &operator++() {
+      //还在块内就直接走
+      if(block_it) {
+        sync();
+        chunk_it_type next = chunk_it;
+        if(++next != block_it->chunk->end()) {
+          chunk_it = next;
+          return *this;
+        }
+      }
       return *this = *this + 1;
     }
     /**
@@ -696,12 +2307,14 @@ public:
      * *it
      */
     const T &operator*() const {
+      sync();
       return *chunk_it;
     }
     /**
      * it->field
      */
     const T *operator->() const noexcept {
+      sync();
       return chunk_it.operator->();
     }
 
@@ -710,12 +2323,16 @@ public:
      * memory).
      */
     bool operator==(const iterator &rhs) const {
-      if(dq_it == rhs.dq_it && list_it == rhs.list_it && chunk_it == rhs.chunk_it)
+      sync();
+      rhs.sync();
+      if(dq_it == rhs.dq_it && block_it == rhs.block_it && chunk_it == rhs.chunk_it)
         return true;
       return false;
     }
     bool operator==(const const_iterator &rhs) const {
-      if(dq_it == rhs.dq_it && list_it == rhs.list_it && chunk_it == rhs.chunk_it)
+      sync();
+      rhs.sync();
+      if(dq_it == rhs.dq_it && block_it == rhs.block_it && chunk_it == rhs.chunk_it)
         return true;
       return false;
     }
@@ -731,75 +2348,532 @@ public:
   };
 
   //------------------------------
-  size_t init_size(const typename deque::iterator& it) {
-    size_t cnt = 0;
-    list_it_type list_it_ = data.begin();
-    while(list_it_ != it.list_it && list_it_ != data.end()) {
-      cnt += list_it_->size();
-      list_it_++;
+  size_t init_size(block_it_type block_it_, const chunk_it_type &chunk_it_) const {
+    if(block_it_ == nullptr)
+      return sum_s;
+    return index.prefix(block_it_->ord) + Chunk::init_size(*block_it_->chunk, chunk_it_);
+  }
+  size_t init_size(const typename deque::iterator& it) const {
+    it.sync();
+    return init_size(it.block_it, it.chunk_it);
+  }
+  //end看成在最后一块之后
+  size_t rank(block_it_type block_it_) const {
+    return block_it_ ? block_it_->ord : index.hi;
+  }
+  /**
+   * find the pos-th element (end() if pos == size()) through the index.
+   */
+  std::pair<block_it_type, chunk_it_type> locate(size_t pos) const {
+    if(pos >= sum_s)
+      return std::make_pair(block_it_type(nullptr), chunk_it_type());
+    block_it_type block_it_ = index.map[index.locate(pos, sum_s)];
+    return std::make_pair(block_it_, block_it_->chunk->nth(pos));
+  }
+  /**
+   * walk the chunks from (b, c) to (to, to_c) and hand each piece to f as
+   * segments f(first, last) of Chunk::segment_iterator; f returns false to
+   * stop. return false if stopped.
+   */
+  template<class F> bool scan_segments(block_it_type b, chunk_it_type c, block_it_type to, chunk_it_type to_c, F &f) const {
+    while(b != to) {
+      if(!b->chunk->segments(c, b->chunk->end(), f))
+        return false;
+      b = index.next(b);
+      if(b)
+        c = b->chunk->begin();
+    }
+    return b == nullptr || b->chunk->segments(c, to_c, f);
+  }
+  template<class F> bool segments(const_iterator first, const_iterator last, F &f) const {
+    if(first.dq_it != this || last.dq_it != this || last < first)
+      throw invalid_iterator();
+    first.sync();
+    last.sync();
+    return scan_segments(first.block_it, first.chunk_it, last.block_it, last.chunk_it, f);
+  }
+  //f可能要写 共用的块先复制出来 迭代器跟着挪过去
+  template<class F> bool segments(iterator first, iterator last, F &f) {
+    if(first.dq_it != this || last.dq_it != this || last < first)
+      throw invalid_iterator();
+    if(shares) {
+      for(block_it_type b = first.block_it; b != last.block_it; b = index.next(b))
+        own(b, true);
+      if(last.block_it)
+        own(last.block_it, true);
+    }
+    first.sync();
+    last.sync();
+    return scan_segments(first.block_it, first.chunk_it, last.block_it, last.chunk_it, f);
+  }
+  //pool第一次要用时才建
+  block_it_type make_block() {
+    if(!pool)
+      pool = pool_type::create();
+    return new block(pool);
+  }
+  //有留着的空块先用 其次是对象里的那块
+  block_it_type new_block() {
+    if(spare) {
+      block_it_type b = spare;
+      spare = b->next_spare;
+      spare_n--;
+      return b;
+    }
+    if(block_it_type b = local.open())
+      return b;
+    return make_block();
+  }
+  //对象里的那块不delete 元素清掉 下次new_block再用
+  void free_block(block_it_type b) {
+    if(!local.holds(b)) {
+      delete b;
+      return;
+    }
+    local.close();
+  }
+  /**
+   * the local block of from sits in slot ord of at, which this deque has
+   * taken over: move its elements into a block of this deque put there.
+   */
+  void take_local(deque &from, index_type &at) {
+    block_it_type l = from.local.used();
+    size_t ord = l->ord;
+    block_it_type b = new_block();
+    b->chunk->add(std::move(*l->chunk));
+    b->ord = ord;
+    at.map[ord] = b;
+    from.free_block(l);
+  }
+  //对象里的块在用的话 元素挪到堆上的块 之后swap/移动只换指针
+  void spill() {
+    if(local.used())
+      take_local(*this, index);
+  }
+  void keep_spare(block_it_type b) {
+    b->next_spare = spare;
+    spare = b;
+    spare_n++;
+  }
+  /**
+   * b was just taken out of the map: empty it and keep it for reuse,
+   * unless its chunk is still shared with a snapshot. the local block
+   * is only emptied, new_block() takes it again anyway.
+   */
+  void retire(block_it_type b) {
+    if(local.holds(b)) {
+      free_block(b);
+      return;
+    }
+    if(b->chunk->refs.load(std::memory_order_acquire) != 1) {
+      delete b;
+      return;
+    }
+    b->chunk->forget();
+    b->chunk->clear();
+    keep_spare(b);
+    if(spare_n > std::max(spare_high, spare_floor))
+      trim(std::max(spare_low, spare_floor));
+  }
+  //留着的空块只剩k个
+  void trim(size_t k) {
+    while(spare_n > k)
+      delete new_block();
+  }
+  /**
+   * make the chunk of b this deque's own before writing to it: a chunk
+   * shared with a snapshot is cloned. return whether it was cloned; the
+   * iterators into b move to the clone on their next use (iterator::sync).
+   * keep_origin is for writes that move no element: the clone keeps the
+   * old chunk, so that iterators into it still find their element. any
+   * other write lets the old chunk go.
+   */
+  bool own(block_it_type b, bool keep_origin = false) {
+    if(!shares)
+      return false;
+    shared_chunk *c = b->chunk;
+    if(c->refs.load(std::memory_order_acquire) == 1) {
+      if(!keep_origin)
+        c->forget();
+      return false;
     }
-    if(list_it_ == data.end()) {
-      if(it.list_it == data.end())
-        return cnt;
-      return -1;
+    shared_chunk *copy = new shared_chunk(pool);
+    *copy = *c;
+    if(keep_origin && Chunk::keeps_nodes)
+      copy->origin = c;
+    else
+      shared_chunk::drop(c);
+    b->chunk = copy;
+    return true;
+  }
+  //pos跟着挪到复制出来的块里 位置在复制之前数好 缓存的下标在push_front之后就不对了
+  void own(const iterator &pos, bool keep_origin = false) {
+    pos.sync();
+    block_it_type b = pos.block_it;
+    if(!b)
+      return;
+    if(!shares || b->chunk->refs.load(std::memory_order_acquire) == 1) {
+      own(b, keep_origin);
+      return;
     }
-    cnt += double_list<T>::init_size(*list_it_, it.chunk_it);
-    return cnt;
+    size_t k = Chunk::init_size(*b->chunk, pos.chunk_it);
+    own(b, keep_origin);
+    pos.chunk_it = b->chunk->nth(k);
+  }
+  /**
+   * where chunk_it, taken before the chunk of b was cloned, is in it.
+   */
+  size_t position(block_it_type b, const chunk_it_type &chunk_it_) const {
+    const shared_chunk *from = b->chunk->origin;
+    if(from && chunk_it_.current_list == from)
+      return Chunk::init_size(*from, chunk_it_);
+    return chunk_it_.idx;
   }
   //------------------------------
-  deque() {
+  deque() : pool(nullptr), sizing(sizeof(T)), spare(nullptr), spare_n(0), spare_floor(0), shares(false) {
     sum_s = 0;
-    chunk_s = standard_size();
   }
   deque(const deque &other) : deque() {
     *this = other;
   }
+  /**
+   * n copies of value, laid out in balanced chunks.
+   */
+  deque(size_t n, const T &value) : deque() {
+    insert(end(), n, value);
+  }
+  template<class It, class = typename std::enable_if<!std::is_integral<It>::value>::type>
+  deque(It first, It last) : deque() {
+    insert(end(), first, last);
+  }
+  //只交换块指针数组和pool O(1) 对象里的块先挪到堆上(见spill)
   deque(deque&& other) : deque() {
-    *this = std::move(other);
+    swap(other);
+  }
+  ~deque() {
+    clear();
+    if(pool)
+      pool->detach();
   }
-  ~deque() {}
   deque &operator=(const deque &other) {
+    if(this == &other)
+      return *this;
+    //先复制到tmp里 拷贝构造抛出时*this不变
+    deque tmp;
+    tmp.sizing = other.sizing;
+    for (size_t i = other.index.lo; i < other.index.hi; i++) {
+      block_it_type block_it_ = tmp.new_block();
+      try {
+        *block_it_->chunk = *other.index.map[i]->chunk;
+      }catch(...) {
+        tmp.free_block(block_it_);
+        throw;
+      }
+      tmp.index.push_back(block_it_);
+    }
+    tmp.sum_s = other.sum_s;
+    //swap会把tmp对象里的块挪到堆上 清空以后接过来 元素就挪进自己对象里那块
+    if(local_n > 0) {
+      clear();
+      append(std::move(tmp));
+    }else
+      swap(tmp);
+    return *this;
+  }
+  deque &operator=(deque &&other) {
     if(this == &other)
       return *this;
     this->clear();
-    sum_s = other.sum_s;
-    chunk_s = other.chunk_s;
-    for (auto it_ = other.data.begin(); it_ != other.data.end(); it_++)
-      this->data.insert_tail(*it_);
+    swap(other);
     return *this;
   }
+  /**
+   * replace the contents with n copies of value / the range [first, last).
+   */
+  void assign(size_t n, const T &value) {
+    //value可能就在这个deque里
+    T value_(value);
+    clear();
+    insert(end(), n, value_);
+  }
+  template<class It, class = typename std::enable_if<!std::is_integral<It>::value>::type>
+  void assign(It first, It last) {
+    clear();
+    insert(end(), first, last);
+  }
+  /**
+   * exchange the contents with other in O(1), only pointers are swapped.
+   * with local_n > 0 a local block in use first moves its elements to a
+   * block on the heap (spill), which may allocate.
+   * iterators of both deques are invalidated.
+   */
+  void swap(deque &other) {
+    if(this == &other)
+      return;
+    //空块是按各自的pool建的 不跟着换
+    trim(spare_floor = 0);
+    other.trim(other.spare_floor = 0);
+    spill();
+    other.spill();
+    std::swap(pool, other.pool);
+    index.swap(other.index);
+    std::swap(sum_s, other.sum_s);
+    std::swap(sizing, other.sizing);
+    bool shares_ = shares;
+    shares = other.shares.load();
+    other.shares = shares_;
+  }
+  /**
+   * a copy sharing every chunk with this deque, in O(#chunks).
+   * push / pop / at / insert / erase and the iterators clone a shared
+   * chunk only when they first write to it, so begin() / end() stay O(1)
+   * and only the chunks written to are copied. the copy and this deque
+   * may be used from different threads afterwards.
+   */
+  deque snapshot() const {
+    deque res;
+    res.use_pool(pool);
+    res.sum_s = sum_s;
+    res.sizing = sizing;
+    for(size_t i = index.lo; i < index.hi; i++) {
+      if(!local.holds(index.map[i])) {
+        res.index.push_back(new block(index.map[i]->chunk));
+        continue;
+      }
+      //对象里的块不共用 元素复制到res自己的那块
+      block_it_type b = res.new_block();
+      *b->chunk = *index.map[i]->chunk;
+      res.index.push_back(b);
+    }
+    shares = res.shares = true;
+    return res;
+  }
+  //和别的deque共用p 从此分配都要加锁
+  void use_pool(pool_type *p) {
+    if(!p || p == pool)
+      return;
+    trim(spare_floor = 0);
+    p->share();
+    p->attach();
+    if(pool)
+      pool->detach();
+    pool = p;
+  }
+  /**
+   * move every element of other to the end / the front of this deque by
+   * relinking its chunks, O(#chunks) and no element is moved.
+   * other becomes empty, iterators of both deques are invalidated.
+   */
+  void append(deque &&other) {
+    if(this == &other)
+      return;
+    size_t n = other.sum_s;
+    index_type fresh;
+    take_blocks(other, fresh);
+    splice_blocks(iterator(this, nullptr, chunk_it_type()), fresh, n);
+  }
+  void prepend(deque &&other) {
+    if(this == &other)
+      return;
+    size_t n = other.sum_s;
+    index_type fresh;
+    take_blocks(other, fresh);
+    auto found = locate(0);
+    splice_blocks(iterator(this, found.first, found.second), fresh, n);
+  }
+  /**
+   * cut the deque at pos: the elements from pos on are returned as a new
+   * deque and this keeps the ones before. only the chunk of pos is cut,
+   * the chunks after it are relinked. O(#chunks).
+   * iterators from pos on are invalidated.
+   */
+  deque split_at(iterator pos) {
+    if(pos.dq_it != this || pos == iterator())
+      throw invalid_iterator();
+    deque res;
+    if(pos.block_it == nullptr)
+      return res;
+    //先和这边用同一个pool 块都接过去以后再换成res自己的
+    if(shares)
+      res.use_pool(pool);
+    else if(pool) {
+      pool->attach();
+      res.pool = pool;
+    }
+    res.shares = shares.load();
+    own(pos);
+    size_t k = Chunk::init_size(*pos.block_it->chunk, pos.chunk_it);
+    size_t ord = pos.block_it->ord, m = sum_s - init_size(pos);
+    if(k > 0) {
+      block_it_type back_ = res.new_block();
+      pos.block_it->chunk->cut(k, *back_->chunk);
+      index.sub(ord, back_->size());
+      res.index.push_back(back_);
+      ord++;
+    }
+    block_it_type l = local.used();
+    bool moved = l && l->ord >= ord;
+    for(size_t i = ord; i < index.hi; i++)
+      res.index.push_back(index.map[i]);
+    index.erase(ord, index.hi);
+    if(moved)
+      res.take_local(*this, res.index);
+    if(!shares)
+      res.own_pool();
+    sum_s -= m;
+    fix_chunk_s();
+    res.sum_s = m;
+    res.fix_chunk_s();
+    return res;
+  }
+  /**
+   * move every chunk to a new pool used by this deque only, so it can go
+   * to another thread without locking the old one (see node_pool::adopt).
+   */
+  void own_pool() {
+    if(!pool)
+      return;
+    pool_type *p = pool_type::create();
+    for(size_t i = index.lo; i < index.hi; i++)
+      if(!local.holds(index.map[i]))
+        index.map[i]->chunk->move_to(p);
+    pool->detach();
+    pool = p;
+  }
+  deque split_at(size_t pos) {
+    if(pos > sum_s)
+      throw index_out_of_bound();
+    auto found = locate(pos);
+    return split_at(iterator(this, found.first, found.second));
+  }
+  /**
+   * sort every chunk on its own.
+   */
+  template<class Comp> void sort_chunks(Comp &comp) {
+    for(size_t i = index.lo; i < index.hi; i++) {
+      own(index.map[i]);
+      index.map[i]->chunk->sort(comp);
+    }
+  }
+  /**
+   * k-way merge of the chunks, each sorted already, into new chunks of
+   * about each elements. a tournament tree of losers over the first
+   * elements of the chunks picks the smallest with log(#chunks)
+   * comparisons; the elements are taken off the old chunks one at a time
+   * (the nodes are relinked for double_list) and a drained chunk is freed
+   * at once, so the memory in use stays about size().
+   * if comp throws, every element is kept but the order is unspecified.
+   */
+  template<class Comp> void merge_chunks(Comp &comp, size_t each) {
+    size_t k = index.count(), n = sum_s;
+    if(k < 2)
+      return;
+    size_t cnt = (n + each - 1) / each, made = 0;
+    //块的第一个元素也记下来 比较时少走两层指针 块空了key是nullptr
+    struct entry {
+      const T *key;
+      block_it_type b;
+    };
+    std::unique_ptr<entry[]> leaf(new entry[k]);
+    std::unique_ptr<size_t[]> loser(new size_t[k]), win(new size_t[2 * k]);
+    std::unique_ptr<block_it_type[]> out(new block_it_type[cnt]());
+    for(size_t i = 0; i < k; i++) {
+      leaf[i].b = index.map[index.lo + i];
+      own(leaf[i].b);
+      leaf[i].key = &*leaf[i].b->chunk->begin();
+    }
+    index.clear();
+    auto before = [&](size_t a, size_t b) {
+      if(!leaf[a].key || !leaf[b].key)
+        return leaf[b].key == nullptr && leaf[a].key != nullptr;
+      return comp(*leaf[a].key, *leaf[b].key);
+    };
+    try {
+      //叶子是k..2k-1 内部结点记输的那个
+      for(size_t i = 0; i < k; i++)
+        win[k + i] = i;
+      for(size_t p = k - 1; p > 0; p--) {
+        size_t a = win[2 * p], b = win[2 * p + 1];
+        win[p] = before(b, a) ? b : a;
+        loser[p] = before(b, a) ? a : b;
+      }
+      size_t top = win[1];
+      for(; made < cnt; made++) {
+        out[made] = new_block();
+        for(size_t j = n / cnt + (made < n % cnt); j > 0; j--) {
+          block_it_type b = leaf[top].b;
+          b->chunk->move_head(*out[made]->chunk);
+          if(b->chunk->empty()) {
+            free_block(b);
+            leaf[top].b = nullptr;
+            leaf[top].key = nullptr;
+          }else
+            leaf[top].key = &*b->chunk->begin();
+          //从叶子往上重赛一遍
+          for(size_t p = (top + k) / 2; p > 0; p /= 2)
+            if(before(loser[p], top))
+              std::swap(loser[p], top);
+        }
+      }
+    }catch(...) {
+      //元素都还在 放回去
+      for(size_t i = 0; i <= made && i < cnt; i++) {
+        if(out[i] && out[i]->chunk->empty())
+          free_block(out[i]);
+        else if(out[i])
+          index.push_back(out[i]);
+      }
+      for(size_t i = 0; i < k; i++)
+        if(leaf[i].b)
+          index.push_back(leaf[i].b);
+      throw;
+    }
+    for(size_t i = 0; i < cnt; i++)
+      index.push_back(out[i]);
+  }
   //------------------------------
-  bool if_split(const list_it_type& pos) {
-    return (pos->size() > standard_size() * spilt_index);
+  bool if_split(const block_it_type& pos) {
+    return pos->chunk->size() > split_size();
   }
-  bool if_merge(const list_it_type pos) {
-    if(pos == data.begin() || pos == --data.end())
+  bool if_merge(const block_it_type pos) {
+    if(pos == index.front() || pos == index.back())
       return false;
     //考虑首位情况不merge
-    return (pos->size() < standard_size() * merge_index);
-  }
-  list_it_type do_split(const list_it_type& pos) {
-    double_list<T> split_front, split_back;
-    auto split_result = double_list<T>::split(*pos, (pos->size() + 1) / 2);
-    split_front = split_result.first;
-    split_back = split_result.second;
-    list_it_type substitute = data.erase(pos);
-    substitute = data.insert(substitute, split_back);
-    substitute = data.insert(substitute, split_front);
-    return substitute;
-  }
-  list_it_type do_merge(const list_it_type& pos) {
-    list_it_type substitute, del_front = pos, del_back = pos;
+    return pos->chunk->size() < sizing.merge;
+  }
+  /**
+   * split the block of pos in halves, the front half stays in the old
+   * block and the back half goes to a new block after it.
+   * return where the element of pos is now, no walk from begin() needed.
+   */
+  iterator do_split(const iterator &pos) {
+    block_it_type b = pos.block_it;
+    size_t k = Chunk::init_size(*b->chunk, pos.chunk_it), half = (b->chunk->size() + 1) / 2;
+    //只挪节点 不拷贝元素
+    block_it_type substitute = new_block();
+    b->chunk->cut(half, *substitute->chunk);
+    index.insert(b->ord + 1, substitute);
+    if(k < half)
+      return iterator(this, b, b->chunk->nth(k));
+    return iterator(this, substitute, substitute->chunk->nth(k - half));
+  }
+  /**
+   * merge the block of pos with the smaller neighbour (the next one for
+   * the second block, the previous one for the second last block).
+   * return where the element of pos is now.
+   */
+  iterator do_merge(const iterator &pos) {
+    block_it_type b = pos.block_it;
+    block_it_type substitute, del_front = index.prev(b), del_back = index.next(b);
     bool if_next = false;
-    del_front--, del_back++;
-    if(del_front == data.begin()) {
+    if(del_front == index.front()) {
       substitute = del_back;
       if_next = true;
-    }else if(del_back == --data.end()) {
+    }else if(del_back == index.back()) {
       substitute = del_front;
       if_next = false;
     }else {
-      if(del_front->size() < del_back->size()) {
+      if(del_front->chunk->size() < del_back->chunk->size()) {
         if_next = false;
         substitute = del_front;
       }else {
@@ -807,32 +2881,175 @@ public:
         substitute = del_back;
       }
     }
-    double_list<T> substitute_;
-    if(if_next)
-      substitute_ = double_list<T>::merge(*pos, *substitute);
+    //合到前面那块 后面那块删掉
+    size_t k = Chunk::init_size(*b->chunk, pos.chunk_it);
+    own(substitute);
+    block_it_type keep = if_next ? b : substitute, drop = if_next ? substitute : b;
+    if(!if_next)
+      k += keep->chunk->size();
+    keep->chunk->add(std::move(*drop->chunk));
+    index.erase(drop->ord);
+    free_block(drop);
+    return iterator(this, keep, keep->chunk->nth(k));
+  }
+  //调整块长 pos直接改成调整后的位置
+  void shape(iterator &pos) {
+    if(pos.block_it == nullptr)
+      return;
+    if(if_split(pos.block_it))
+      pos = do_split(pos);
+    if(if_merge(pos.block_it))
+      pos = do_merge(pos);
+  }
+  template<class It, class = void> struct is_forward : std::false_type {};
+  template<class It> struct is_forward<It, decltype(void(typename std::iterator_traits<It>::iterator_category()))>
+    : std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<It>::iterator_category> {};
+  /**
+   * cut n new elements into fresh blocks of (almost) equal size around
+   * sqrt(size() + n); put(b) constructs the next element at the end of b.
+   */
+  template<class Put> void make_blocks(index_type &fresh, size_t n, Put put) {
+    if(n == 0)
+      return;
+    size_t each = standard_size(sum_s + n);
+    size_t cnt = (n + each - 1) / each;
+    try {
+      for(size_t i = 0; i < cnt; i++) {
+        fresh.push_back(new_block());
+        for(size_t j = n / cnt + (i < n % cnt); j > 0; j--)
+          put(fresh.back());
+      }
+    }catch(...) {
+      drop_blocks(fresh);
+      throw;
+    }
+  }
+  template<class It> iterator insert_range(iterator pos, It first, It last, std::true_type) {
+    index_type fresh;
+    size_t n = std::distance(first, last);
+    make_blocks(fresh, n, [&](block_it_type b) { b->chunk->emplace_tail(*first); ++first; });
+    return insert_blocks(pos, fresh, n);
+  }
+  //只能读一遍 不知道有多少个 边读边开新块
+  template<class It> iterator insert_range(iterator pos, It first, It last, std::false_type) {
+    index_type fresh;
+    size_t n = 0, each = 0;
+    try {
+      for(; first != last; ++first, ++n) {
+        if(fresh.count() == 0 || fresh.back()->chunk->size() >= each) {
+          fresh.push_back(new_block());
+          each = standard_size(sum_s + n);
+        }
+        fresh.back()->chunk->emplace_tail(*first);
+      }
+    }catch(...) {
+      drop_blocks(fresh);
+      throw;
+    }
+    return insert_blocks(pos, fresh, n);
+  }
+  void drop_blocks(index_type &fresh) {
+    for(size_t i = fresh.lo; i < fresh.hi; i++)
+      free_block(fresh.map[i]);
+    fresh.clear();
+  }
+  /**
+   * link the n elements in fresh in before pos, the block pos is in is
+   * cut in two if pos is in its middle.
+   */
+  iterator splice_blocks(iterator pos, index_type &fresh, size_t n) {
+    if(n == 0)
+      return pos;
+    block_it_type first_ = fresh.front();
+    size_t ord = index.hi;
+    if(pos.block_it != nullptr) {
+      own(pos);
+      size_t k = Chunk::init_size(*pos.block_it->chunk, pos.chunk_it);
+      if(k > 0) {
+        block_it_type back_ = new_block();
+        pos.block_it->chunk->cut(k, *back_->chunk);
+        index.insert(pos.block_it->ord + 1, back_);
+      }
+      ord = pos.block_it->ord + (k > 0);
+    }
+    index.splice(ord, fresh);
+    sum_s += n;
+    fix_chunk_s();
+    return iterator(this, first_, first_->chunk->begin());
+  }
+  /**
+   * splice_blocks for the inserts: afterwards the blocks on both seams
+   * are merged if one is short (see mend), at the ends as well as in the
+   * middle. append / prepend keep the chunks as they are.
+   */
+  iterator insert_blocks(iterator pos, index_type &fresh, size_t n) {
+    if(n == 0)
+      return pos;
+    block_it_type last_ = fresh.back();
+    iterator res = splice_blocks(pos, fresh, n);
+    block_it_type before = index.prev(res.block_it);
+    mend(last_);
+    size_t k = before ? before->chunk->size() : 0;
+    if(before && mend(before))
+      return iterator(this, before, before->chunk->nth(k));
+    return res;
+  }
+  /**
+   * merge the block after a into a if one of them is shorter than the
+   * merge size and they fit in one block (or both fit in a standard one).
+   * return whether they were merged.
+   */
+  bool mend(block_it_type a) {
+    block_it_type b = index.next(a);
+    if(b == nullptr)
+      return false;
+    size_t m = a->chunk->size() + b->chunk->size();
+    bool short_ = a->chunk->size() < sizing.merge || b->chunk->size() < sizing.merge;
+    if(m > split_size() || (!short_ && m > standard_size()))
+      return false;
+    own(a);
+    own(b);
+    a->chunk->add(std::move(*b->chunk));
+    index.erase(b->ord);
+    free_block(b);
+    return true;
+  }
+  /**
+   * move all the blocks of other into fresh, other becomes empty.
+   */
+  void take_blocks(deque &other, index_type &fresh) {
+    fresh.swap(other.index);
+    if(other.shares) {
+      //块可能还和快照共用 留在other的pool里 这个pool以后两边都用
+      if(!pool)
+        use_pool(other.pool);
+      else if(other.pool && other.pool != pool)
+        other.pool->share();
+    }else if(other.pool) {
+      //节点交给这边的pool 两边各用各的 不用加锁
+      if(!pool)
+        pool = pool_type::create();
+      for(size_t i = fresh.lo; i < fresh.hi; i++)
+        if(!other.local.holds(fresh.map[i]))
+          fresh.map[i]->chunk->move_to(pool);
+    }
+    if(other.local.used())
+      take_local(other, fresh);
+    shares = shares || other.shares;
+    other.sum_s = 0;
+    other.fix_chunk_s();
+  }
+  /**
+   * take an empty block out of the map and free it.
+   */
+  void drop_block(block_it_type pos) {
+    if(pos == index.back())
+      index.pop_back();
+    else if(pos == index.front())
+      index.pop_front();
     else
-      substitute_ = double_list<T>::merge(*substitute, *pos);
-    data.erase(pos);
-    list_it_type substitute_pos = data.erase(substitute);
-    return data.insert(substitute_pos, substitute_);
-  }
-  //return the position of p after change, -1 by default
-  size_t shape(const iterator& pos) {
-    list_it_type list_pos = pos.list_it;
-    if(list_pos == list_it_type() || list_pos == data.end())
-      return -1;
-    size_t ans = -1;
-    if(if_split(list_pos)) {
-      if(ans == -1)
-        ans = init_size(pos);
-      list_pos = do_split(list_pos);
-    }
-    if(if_merge(list_pos)) {
-      if(ans == -1)
-        ans = init_size(pos);
-      list_pos = do_merge(list_pos);
-    }
-    return ans;
+      index.erase(pos->ord);
+    free_block(pos);
   }
   //及时删掉空的chunk
   //------------------------------
@@ -843,30 +3060,21 @@ public:
   T &at(const size_t &pos) {
     if(pos >= sum_s)
       throw index_out_of_bound();
-    if(pos < size() - pos)
-      return *(begin() + pos);
-    else
-      return *(end() - (size() - pos));
+    auto found = locate(pos);
+    iterator it(this, found.first, found.second);
+    own(it, true);
+    return *it.chunk_it;
   }
   const T &at(const size_t &pos) const {
     if(pos >= sum_s)
       throw index_out_of_bound();
-    if (2 * pos < size())
-      return *(cbegin() + pos);
-    else
-      return *(cend() - (size() - pos));
+    return *locate(pos).second;
   }
   T &operator[](const size_t &pos) {
-    if(pos < size() - pos)
-      return *(begin() + pos);
-    else
-      return *(end() - (size() - pos));
+    return at(pos);
   }
   const T &operator[](const size_t &pos) const {
-    if (2 * pos < size())
-      return *(cbegin() + pos);
-    else
-      return *(cend() - (size() - pos));
+    return at(pos);
   }
 
   /**
@@ -897,25 +3105,78 @@ public:
   iterator begin() {
     if(sum_s == 0)
       return end();
-    return iterator(this, data.begin(), data.begin()->begin());
+    return iterator(this, index.front(), index.front()->chunk->begin());
   }
   const_iterator cbegin() const {
     if(sum_s == 0)
       return cend();
-    return const_iterator(this, data.begin(), data.begin()->begin());
+    return const_iterator(this, index.front(), index.front()->chunk->begin());
   }
 
   /**
    * return an iterator to the end.
    */
   iterator end() {
-    return iterator(this, data.end(), chunk_it_type());
+    return iterator(this, nullptr, chunk_it_type());
   }
   const_iterator end() const{
     return cend();
   }
   const_iterator cend() const {
-    return const_iterator(this, data.end(), chunk_it_type());
+    return const_iterator(this, nullptr, chunk_it_type());
+  }
+
+  /**
+   * call f(first, last) on every chunk in order, [first, last) being a
+   * contiguous span (T*) for circular_array or a node range for
+   * double_list. a tight loop over each segment avoids the chunk boundary
+   * check iterator::operator++ does on every step.
+   */
+  template<class F> void for_each_segment(F f) {
+    auto g = [&](typename Chunk::segment_iterator b, typename Chunk::segment_iterator e) { f(b, e); return true; };
+    segments(begin(), end(), g);
+  }
+  template<class F> void for_each_segment(F f) const {
+    auto g = [&](typename Chunk::segment_iterator b, typename Chunk::segment_iterator e) { f(b, e); return true; };
+    segments(cbegin(), cend(), g);
+  }
+
+  /**
+   * whether both hold equal elements in the same order. contiguous
+   * chunks are compared span by span (by simd::equal).
+   */
+  bool operator==(const deque &other) const {
+    if(sum_s != other.sum_s)
+      return false;
+    return equal_spans(other, std::is_pointer<typename Chunk::segment_iterator>());
+  }
+  bool operator!=(const deque &other) const {
+    return !(*this == other);
+  }
+  bool equal_spans(const deque &other, std::false_type) const {
+    for(const_iterator a = cbegin(), b = other.cbegin(); a != cend(); ++a, ++b)
+      if(!(*a == *b))
+        return false;
+    return true;
+  }
+  //两边的块长不一样 每次比两边都连续的那一截
+  bool equal_spans(const deque &other, std::true_type) const {
+    if(sum_s == 0)
+      return true;
+    block_it_type x = index.front(), y = other.index.front();
+    size_t i = 0, j = 0;
+    while(x) {
+      const T *p, *q;
+      size_t m = std::min(x->chunk->span(i, p), y->chunk->span(j, q));
+      if(!simd::equal(p, q, m))
+        return false;
+      i += m, j += m;
+      if(i == x->size())
+        x = index.next(x), i = 0;
+      if(j == y->size())
+        y = other.index.next(y), j = 0;
+    }
+    return true;
   }
 
   /**
@@ -932,13 +3193,83 @@ public:
     return sum_s;
   }
 
+  /**
+   * the number of elements the chunks (spare ones too) and the free
+   * nodes of the pool have room for.
+   */
+  size_t capacity() const {
+    size_t c = pool ? pool->spare() : 0;
+    for(size_t i = index.lo; i < index.hi; i++)
+      c += index.map[i]->chunk->capacity();
+    for(block_it_type b = spare; b; b = b->next_spare)
+      c += b->chunk->capacity();
+    return c;
+  }
+  /**
+   * get ready for n elements: pushing at the ends until size() is n
+   * allocates nothing. spare chunks are made (and kept) for the new
+   * elements, the chunk map gets room for them and the pool enough nodes.
+   * past local_n the elements of the local block move to a block of the
+   * pool, so iterators are invalidated then.
+   */
+  void reserve(size_t n) {
+    if(n <= sum_s)
+      return;
+    if(n > local_n)
+      spill();
+    size_t m = n - sum_s;
+    //一块最多装这么多 块在size为x时开 至少装到standard_size(x) + 1个 两头各有一块没满
+    size_t each = std::max(standard_size(n), sizing.small) + 1;
+    size_t need = 2;
+    for(size_t x = sum_s; x < n; need++)
+      x += standard_size(x + 1) + 1;
+    spare_floor = std::max(spare_floor, need);
+    while(spare_n < need)
+      keep_spare(make_block());
+    for(block_it_type b = spare; b; b = b->next_spare)
+      b->chunk->reserve(each);
+    if(index.count()) {
+      own(index.front());
+      own(index.back());
+      index.front()->chunk->reserve(each);
+      index.back()->chunk->reserve(each);
+    }
+    index.reserve(need);
+    if(pool)
+      pool->reserve(m);
+  }
+  /**
+   * give back what reserve() and the spare chunks hold: spare chunks are
+   * freed, every chunk not shared with a snapshot is cut to its size and
+   * the chunk map to the number of chunks. the slabs of the pool are only
+   * freed once no node is in use.
+   */
+  void shrink_to_fit() {
+    trim(spare_floor = 0);
+    for(size_t i = index.lo; i < index.hi; i++)
+      if(index.map[i]->chunk->refs.load(std::memory_order_acquire) == 1) {
+        index.map[i]->chunk->forget();
+        index.map[i]->chunk->shrink_to_fit();
+      }
+    if(index.map && index.cap > index.spare_cap(index.count()))
+      index.layout(index.spare_cap(index.count()));
+    if(pool)
+      pool->release();
+  }
+
   /**
    * clear all contents.
    */
   void clear() {
-    data.clear();
+    for(size_t i = index.lo; i < index.hi; i++)
+      free_block(index.map[i]);
+    index.clear();
+    trim(spare_floor = 0);
+    shares = false;
+    if(pool)
+      pool->release();
     sum_s = 0;
-    chunk_s = 1;
+    fix_chunk_s();
   }
 
   /**
@@ -947,22 +3278,57 @@ public:
    * throw if the iterator is invalid or it points to a wrong place.
    */
   iterator insert(iterator pos, const T &value) {
+    return emplace(pos, value);
+  }
+  iterator insert(iterator pos, T &&value) {
+    return emplace(pos, std::move(value));
+  }
+  /**
+   * construct an element from args in place before pos.
+   * return an iterator pointing to it.
+   */
+  template<class... Args>
+  iterator emplace(iterator pos, Args&&... args) {
+    if(pos.dq_it != this || pos == iterator())
+      throw invalid_iterator();
+    if(empty()) {
+      index.push_back(new_block());
+      pos = end();
+    }
+    own(pos);
+    shape(pos);
+    if(pos.block_it == nullptr) {
+      pos.block_it = index.back();
+      own(pos.block_it);
+      pos.chunk_it = pos.block_it->chunk->end();
+    }
+    chunk_it_type it_ = pos.block_it->chunk->emplace(pos.chunk_it, std::forward<Args>(args)...);
+    index.add(pos.block_it->ord, 1);
+    sum_s++;
+    fix_chunk_s();
+    return iterator(this, pos.block_it, it_);
+  }
+
+  /**
+   * insert n copies of value / the range [first, last) before pos.
+   * the new elements are cut into fresh chunks of about sqrt(size())
+   * and linked in as a whole, so it costs O(m + sqrt(n)) rather than
+   * m single inserts.
+   * return an iterator pointing to the first inserted element (pos if
+   * nothing is inserted).
+   */
+  iterator insert(iterator pos, size_t n, const T &value) {
+    if(pos.dq_it != this || pos == iterator())
+      throw invalid_iterator();
+    index_type fresh;
+    make_blocks(fresh, n, [&](block_it_type b) { b->chunk->emplace_tail(value); });
+    return insert_blocks(pos, fresh, n);
+  }
+  template<class It, class = typename std::enable_if<!std::is_integral<It>::value>::type>
+  iterator insert(iterator pos, It first, It last) {
     if(pos.dq_it != this || pos == iterator())
       throw invalid_iterator();
-    if(empty()) {
-      data.insert_tail(double_list<T>());
-      pos = end();
-    }
-    size_t shape_result = shape(pos);
-    if(shape_result != size_t(-1))
-      pos = begin() + shape_result;
-    if(pos == end()) {
-      --pos.list_it;
-      pos.chunk_it = pos.list_it->end();
-    }
-    chunk_it_type it_ = pos.list_it->insert(pos.chunk_it, value);
-    sum_s++;
-    return iterator(this, pos.list_it, it_);
+    return insert_range(pos, first, last, is_forward<It>());
   }
 
   /**
@@ -973,43 +3339,123 @@ public:
    */
 
   iterator erase(iterator pos) {
-    if(this != pos.dq_it || pos == end() || empty())
+    if(this != pos.dq_it || pos.block_it == nullptr || empty())
       throw invalid_iterator();
-    size_t shape_result = shape(pos);
-    if(shape_result != size_t(-1)) {
-      if(shape_result < size() - shape_result)
-        pos = begin() + shape_result;
-      else
-        pos = end() - (size() - shape_result);
-    }
-    chunk_it_type chunk_it_ = pos.list_it->erase(pos.chunk_it);
-    list_it_type list_it_ = pos.list_it;
-    if (list_it_ != data.end() && list_it_->empty()) {
-      list_it_ = data.erase(list_it_);
-      if (list_it_ == data.end())
+    own(pos);
+    shape(pos);
+    chunk_it_type chunk_it_ = pos.block_it->chunk->erase(pos.chunk_it);
+    block_it_type block_it_ = pos.block_it;
+    index.sub(block_it_->ord, 1);
+    if (block_it_->chunk->empty()) {
+      block_it_type next = index.next(block_it_);
+      drop_block(block_it_);
+      block_it_ = next;
+      if (block_it_ == nullptr)
         chunk_it_ = chunk_it_type();
       else
-        chunk_it_ = list_it_->begin();
-    } else if (chunk_it_ == list_it_->end()) {
-      ++list_it_;
-      if (list_it_ == data.end())
+        chunk_it_ = block_it_->chunk->begin();
+    } else if (chunk_it_ == block_it_->chunk->end()) {
+      block_it_ = index.next(block_it_);
+      if (block_it_ == nullptr)
         chunk_it_ = chunk_it_type();
       else
-        chunk_it_ = list_it_->begin();
+        chunk_it_ = block_it_->chunk->begin();
     }
   
     sum_s--;
-    return iterator(this, list_it_, chunk_it_);
+  
+    fix_chunk_s();
+    return iterator(this, block_it_, chunk_it_);
+  }
+  /**
+   * remove the elements in [first, last).
+   * the two boundary chunks are trimmed and the chunks in between are
+   * dropped as a whole; what is left of the two is merged if it fits.
+   * return an iterator pointing to the element last pointed to.
+   */
+  iterator erase(iterator first, iterator last) {
+    if(first.dq_it != this || last.dq_it != this || first == iterator() || last == iterator())
+      throw invalid_iterator();
+    if(first == last)
+      return last;
+    if(last < first)
+      throw invalid_iterator();
+    block_it_type front_ = first.block_it, back_ = last.block_it;
+    if(front_ == back_) {
+      size_t k = Chunk::init_size(*front_->chunk, first.chunk_it);
+      size_t m = Chunk::init_size(*front_->chunk, last.chunk_it) - k;
+      if(own(front_)) {
+        first.chunk_it = front_->chunk->nth(k);
+        last.chunk_it = front_->chunk->nth(k + m);
+      }
+      chunk_it_type chunk_it_ = front_->chunk->erase(first.chunk_it, last.chunk_it);
+      index.sub(front_->ord, m);
+      sum_s -= m;
+      fix_chunk_s();
+      if(front_->chunk->empty() || chunk_it_ == front_->chunk->end()) {
+        block_it_type next = index.next(front_);
+        if(front_->chunk->empty())
+          drop_block(front_);
+        return next ? iterator(this, next, next->chunk->begin()) : end();
+      }
+      return iterator(this, front_, chunk_it_);
+    }
+    size_t m = init_size(back_, last.chunk_it) - init_size(front_, first.chunk_it);
+    own(first);
+    own(last);
+    front_->chunk->erase(first.chunk_it, front_->chunk->end());
+    size_t from = front_->chunk->empty() ? front_->ord : front_->ord + 1;
+    size_t to = back_ ? back_->ord : index.hi;
+    if(back_)
+      back_->chunk->erase(back_->chunk->begin(), last.chunk_it);
+    for(size_t i = from; i < to; i++)
+      free_block(index.map[i]);
+    index.erase(from, to);
+    sum_s -= m;
+    fix_chunk_s();
+    if(!back_)
+      return end();
+    //删剩的两截接上了 能并就并 不然反复区间删除会留下很多小块
+    block_it_type a = index.prev(back_);
+    size_t k = a ? a->chunk->size() : 0;
+    if(a && mend(a))
+      return iterator(this, a, a->chunk->nth(k));
+    return iterator(this, back_, back_->chunk->begin());
   }
   
   /**
    * add an element to the end.
    */
   void push_back(const T &value) {
-    if (empty() || (--data.end())->size() > standard_size())
-      data.insert_tail(double_list<T>());
-    (--data.end())->insert_tail(value);
+    emplace_back(value);
+  }
+  void push_back(T &&value) {
+    emplace_back(std::move(value));
+  }
+  /**
+   * construct an element from args at the end.
+   * return a reference to it.
+   */
+  template<class... Args>
+  T &emplace_back(Args&&... args) {
+    if(!empty() && index.back()->chunk->size() <= standard_size()) {
+      own(index.back());
+      index.back()->chunk->emplace_tail(std::forward<Args>(args)...);
+      index.back_grow();
+    }else {
+      //先构造再挂进index 构造抛异常时不会留下空块
+      block_it_type b = new_block();
+      try {
+        b->chunk->emplace_tail(std::forward<Args>(args)...);
+        index.push_back(b);
+      }catch(...) {
+        retire(b);
+        throw;
+      }
+    }
     sum_s++;
+    fix_chunk_s();
+    return *--index.back()->chunk->end();
   }
   /**
    * remove the last element.
@@ -1019,22 +3465,77 @@ public:
   void pop_back() {
     if(empty())
       throw container_is_empty();
-    (--data.end())->delete_tail();
-    auto it = --data.end();
-    if (it != data.end() && it->empty()) {
-      data.erase(it);
+    block_it_type it = index.back();
+    own(it);
+    it->chunk->delete_tail();
+    index.back_shrink();
+    if (it->chunk->empty()) {
+      index.pop_back();
+      retire(it);
     }
     sum_s--;
+    fix_chunk_s();
+  }
+
+  /**
+   * remove the last n elements, whole chunks are dropped at once.
+   * throw index_out_of_bound when there are less than n elements.
+   */
+  void pop_back(size_t n) {
+    if(n > sum_s)
+      throw index_out_of_bound();
+    //sum_s跟着每一步减 own抛异常时也和块对得上
+    while(n > 0 && index.back()->chunk->size() <= n) {
+      block_it_type it = index.back();
+      n -= it->chunk->size();
+      sum_s -= it->chunk->size();
+      index.sub(it->ord, it->chunk->size());
+      index.pop_back();
+      retire(it);
+    }
+    if(n > 0) {
+      block_it_type it = index.back();
+      own(it);
+      it->chunk->erase(it->chunk->nth(it->chunk->size() - n), it->chunk->end());
+      index.sub(it->ord, n);
+      sum_s -= n;
+    }
+    fix_chunk_s();
   }
 
   /**
    * insert an element to the beginning.
    */
   void push_front(const T &value) {
-    if(empty() || data.begin()->size() > standard_size())
-      data.insert_head(double_list<T>());
-    data.begin()->insert_head(value);
+    emplace_front(value);
+  }
+  void push_front(T &&value) {
+    emplace_front(std::move(value));
+  }
+  /**
+   * construct an element from args at the beginning.
+   * return a reference to it.
+   */
+  template<class... Args>
+  T &emplace_front(Args&&... args) {
+    if(!empty() && index.front()->chunk->size() <= standard_size()) {
+      own(index.front());
+      index.front()->chunk->emplace_head(std::forward<Args>(args)...);
+      index.front_grow();
+    }else {
+      //先构造再挂进index 构造抛异常时不会留下空块
+      block_it_type b = new_block();
+      try {
+        b->chunk->emplace_head(std::forward<Args>(args)...);
+        index.push_front(b);
+      }catch(...) {
+        retire(b);
+        throw;
+      }
+    }
     sum_s++;
+    fix_chunk_s();
+    return *index.front()->chunk->begin();
   }
 
   /**
@@ -1045,15 +3546,1271 @@ public:
   void pop_front() {
     if(empty())
       throw container_is_empty();
+    block_it_type it = index.front();
+    own(it);
     sum_s--;
-    data.begin()->delete_head();
-    auto it = data.begin();
-    if (it != data.end() && it->empty()) {
-      data.erase(it);
+    fix_chunk_s();
+    it->chunk->delete_head();
+    index.front_shrink();
+    if (it->chunk->empty()) {
+      index.pop_front();
+      retire(it);
+    }
+  }
+  /**
+   * remove the first n elements, whole chunks are dropped at once.
+   * throw index_out_of_bound when there are less than n elements.
+   */
+  void pop_front(size_t n) {
+    if(n > sum_s)
+      throw index_out_of_bound();
+    //sum_s跟着每一步减 own抛异常时也和块对得上
+    while(n > 0 && index.front()->chunk->size() <= n) {
+      block_it_type it = index.front();
+      n -= it->chunk->size();
+      sum_s -= it->chunk->size();
+      index.sub(it->ord, it->chunk->size());
+      index.pop_front();
+      retire(it);
+    }
+    if(n > 0) {
+      block_it_type it = index.front();
+      own(it);
+      it->chunk->erase(it->chunk->begin(), it->chunk->nth(n));
+      index.sub(it->ord, n);
+      sum_s -= n;
+    }
+    fix_chunk_s();
+  }
+};
+
+template<class It, class = void> struct is_segmented : std::false_type {};
+template<class It> struct is_segmented<It, decltype(void(typename It::deque_type()))> : std::true_type {};
+
+/**
+ * segmented versions of the common algorithms for deque iterators:
+ * the range is scanned chunk by chunk with a tight loop per segment
+ * (see deque::for_each_segment).
+ */
+template<class It, class F>
+typename std::enable_if<is_segmented<It>::value, F>::type for_each(It first, It last, F f) {
+  auto g = [&](auto b, auto e) {
+    for(; b != e; ++b)
+      f(*b);
+    return true;
+  };
+  first.dq_it->segments(first, last, g);
+  return f;
+}
+template<class It, class Out>
+typename std::enable_if<is_segmented<It>::value, Out>::type copy(It first, It last, Out out) {
+  auto g = [&](auto b, auto e) {
+    for(; b != e; ++b, ++out)
+      *out = *b;
+    return true;
+  };
+  first.dq_it->segments(typename It::deque_type::const_iterator(first), last, g);
+  return out;
+}
+//找不到返回last
+/**
+ * the per-segment loops of find / count / min_element / max_element.
+ * a segment of T* goes to the simd kernels if T has one, any other
+ * segment is walked element by element.
+ */
+template<class It, class V> bool seg_find(It b, It e, const V &value, size_t &k) {
+  for(; b != e; ++b, ++k)
+    if(*b == value)
+      return true;
+  return false;
+}
+template<class T> typename std::enable_if<simd::has_kernel<T>::value, bool>::type seg_find(T *b, T *e, const T &value, size_t &k) {
+  const T *p = simd::find<T>(b, e, value);
+  k += p - b;
+  return p != e;
+}
+template<class It, class V> size_t seg_count(It b, It e, const V &value) {
+  size_t ans = 0;
+  for(; b != e; ++b)
+    ans += *b == value;
+  return ans;
+}
+template<class T> typename std::enable_if<simd::has_kernel<T>::value, size_t>::type seg_count(T *b, T *e, const T &value) {
+  return simd::count<T>(b, e, value);
+}
+//[b, e)非空 返回第一个最小的 off是它在段里的位置 len是段长
+template<class It> auto seg_min(It b, It e, size_t &off, size_t &len) -> decltype(&*b) {
+  auto ans = &*b;
+  off = 0, len = 1;
+  for(++b; b != e; ++b, ++len)
+    if(*b < *ans)
+      ans = &*b, off = len;
+  return ans;
+}
+template<class T> typename std::enable_if<simd::has_kernel<T>::value, const T*>::type seg_min(T *b, T *e, size_t &off, size_t &len) {
+  const T *p = simd::min<T>(b, e);
+  off = p - b, len = e - b;
+  return p;
+}
+template<class It> auto seg_max(It b, It e, size_t &off, size_t &len) -> decltype(&*b) {
+  auto ans = &*b;
+  off = 0, len = 1;
+  for(++b; b != e; ++b, ++len)
+    if(*ans < *b)
+      ans = &*b, off = len;
+  return ans;
+}
+template<class T> typename std::enable_if<simd::has_kernel<T>::value, const T*>::type seg_max(T *b, T *e, size_t &off, size_t &len) {
+  const T *p = simd::max<T>(b, e);
+  off = p - b, len = e - b;
+  return p;
+}
+
+//找不到返回last
+template<class It, class V>
+typename std::enable_if<is_segmented<It>::value, It>::type find(It first, It last, const V &value) {
+  size_t k = 0;
+  auto g = [&](auto b, auto e) { return !seg_find(b, e, value, k); };
+  if(first.dq_it->segments(typename It::deque_type::const_iterator(first), last, g))
+    return last;
+  return first + int(k);
+}
+template<class It, class V>
+typename std::enable_if<is_segmented<It>::value, size_t>::type count(It first, It last, const V &value) {
+  size_t ans = 0;
+  auto g = [&](auto b, auto e) {
+    ans += seg_count(b, e, value);
+    return true;
+  };
+  first.dq_it->segments(typename It::deque_type::const_iterator(first), last, g);
+  return ans;
+}
+/**
+ * the first smallest / largest element of [first, last), last if empty.
+ */
+template<class It>
+typename std::enable_if<is_segmented<It>::value, It>::type min_element(It first, It last) {
+  const typename It::value_type *best = nullptr;
+  size_t k = 0, pos = 0;
+  auto g = [&](auto b, auto e) {
+    if(b == e)
+      return true;
+    size_t off, len;
+    auto p = seg_min(b, e, off, len);
+    if(!best || *p < *best)
+      best = p, pos = k + off;
+    k += len;
+    return true;
+  };
+  first.dq_it->segments(typename It::deque_type::const_iterator(first), last, g);
+  return best ? first + int(pos) : last;
+}
+template<class It>
+typename std::enable_if<is_segmented<It>::value, It>::type max_element(It first, It last) {
+  const typename It::value_type *best = nullptr;
+  size_t k = 0, pos = 0;
+  auto g = [&](auto b, auto e) {
+    if(b == e)
+      return true;
+    size_t off, len;
+    auto p = seg_max(b, e, off, len);
+    if(!best || *best < *p)
+      best = p, pos = k + off;
+    k += len;
+    return true;
+  };
+  first.dq_it->segments(typename It::deque_type::const_iterator(first), last, g);
+  return best ? first + int(pos) : last;
+}
+template<class It, class V>
+typename std::enable_if<is_segmented<It>::value, V>::type accumulate(It first, It last, V init) {
+  auto g = [&](auto b, auto e) {
+    for(; b != e; ++b)
+      init = init + *b;
+    return true;
+  };
+  first.dq_it->segments(typename It::deque_type::const_iterator(first), last, g);
+  return init;
+}
+template<class It, class V, class Op>
+typename std::enable_if<is_segmented<It>::value, V>::type accumulate(It first, It last, V init, Op op) {
+  auto g = [&](auto b, auto e) {
+    for(; b != e; ++b)
+      init = op(init, *b);
+    return true;
+  };
+  first.dq_it->segments(typename It::deque_type::const_iterator(first), last, g);
+  return init;
+}
+
+/**
+ * sort q by comp (operator< by default) in O(n log n): every chunk is
+ * sorted on its own, then the chunks are merged k-way into new chunks of
+ * the standard size. no second copy of the elements is made.
+ * not stable.
+ */
+template<class T, class Chunk, class Policy, class Comp>
+void sort(deque<T, Chunk, Policy> &q, Comp comp) {
+  q.sort_chunks(comp);
+  q.merge_chunks(comp, q.standard_size(q.size()));
+}
+template<class T, class Chunk, class Policy>
+void sort(deque<T, Chunk, Policy> &q) {
+  sort(q, [](const T &a, const T &b) { return a < b; });
+}
+
+/**
+ * multi-threaded algorithms over a whole deque. the chunks are cut into
+ * runs of neighbouring chunks holding about the same number of elements,
+ * one run per thread; the calling thread takes the first run.
+ * f is called from several threads at once, so it must not touch shared
+ * state without its own locking. the first exception thrown by f is
+ * rethrown after every thread has finished.
+ */
+namespace parallel {
+
+//threads为0时用硬件线程数
+inline size_t thread_count(size_t threads) {
+  if(threads == 0)
+    threads = std::thread::hardware_concurrency();
+  return threads == 0 ? 1 : threads;
+}
+/**
+ * cut the chunk slots of q into at most threads runs by element count,
+ * run r is the slots [cut[r], cut[r + 1]). return the number of runs.
+ */
+template<class DQ> size_t cut_runs(const DQ &q, size_t threads, size_t *cut) {
+  size_t runs = 0, done = 0;
+  cut[0] = q.index.lo;
+  for(size_t i = q.index.lo; i < q.index.hi; i++) {
+    done += q.index.map[i]->size();
+    //前runs+1份的元素够了就在这里断开
+    if(done * threads >= q.size() * (runs + 1))
+      cut[++runs] = i + 1;
+  }
+  return runs;
+}
+/**
+ * call work(r, from, to) for every run, runs 1.. on new threads.
+ */
+template<class Work> void run(size_t runs, const size_t *cut, Work &work) {
+  if(runs == 0)
+    return;
+  std::unique_ptr<std::thread[]> th(new std::thread[runs]);
+  std::unique_ptr<std::exception_ptr[]> err(new std::exception_ptr[runs]);
+  auto job = [&](size_t r) {
+    try {
+      work(r, cut[r], cut[r + 1]);
+    }catch(...) {
+      err[r] = std::current_exception();
+    }
+  };
+  for(size_t r = 1; r < runs; r++) {
+    try {
+      th[r] = std::thread(job, r);
+    }catch(...) {
+      //开不出线程就自己做
+      job(r);
     }
   }
+  job(0);
+  for(size_t r = 1; r < runs; r++)
+    if(th[r].joinable())
+      th[r].join();
+  for(size_t r = 0; r < runs; r++)
+    if(err[r])
+      std::rethrow_exception(err[r]);
+}
+/**
+ * call f(x) on every element of q, threads threads at most.
+ */
+template<class T, class Chunk, class Policy, class F>
+void for_each(deque<T, Chunk, Policy> &q, F f, size_t threads = 0) {
+  threads = thread_count(threads);
+  std::unique_ptr<size_t[]> cut(new size_t[threads + 1]);
+  size_t runs = cut_runs(q, threads, cut.get());
+  //共用的块会在各个线程里复制 pool要加锁
+  if(q.shares && q.pool)
+    q.pool->share();
+  auto work = [&](size_t, size_t from, size_t to) {
+    auto g = [&](auto b, auto e) {
+      for(; b != e; ++b)
+        f(*b);
+      return true;
+    };
+    for(size_t i = from; i < to; i++) {
+      auto b = q.index.map[i];
+      q.own(b, true);
+      b->chunk->segments(b->chunk->begin(), b->chunk->end(), g);
+    }
+  };
+  run(runs, cut.get(), work);
+}
+/**
+ * replace every element x of q by f(x).
+ */
+template<class T, class Chunk, class Policy, class F>
+void transform(deque<T, Chunk, Policy> &q, F f, size_t threads = 0) {
+  for_each(q, [&](T &x) { x = f(x); }, threads);
+}
+/**
+ * fill dst with f(x) for every element x of src, in order.
+ * every thread builds its part in a deque of its own, the parts are then
+ * linked together by append() without moving elements.
+ */
+template<class T, class Chunk, class Policy, class U, class Chunk2, class Policy2, class F>
+void transform(const deque<T, Chunk, Policy> &src, deque<U, Chunk2, Policy2> &dst, F f, size_t threads = 0) {
+  threads = thread_count(threads);
+  std::unique_ptr<size_t[]> cut(new size_t[threads + 1]);
+  size_t runs = cut_runs(src, threads, cut.get());
+  std::unique_ptr<deque<U, Chunk2, Policy2>[]> part(new deque<U, Chunk2, Policy2>[runs]);
+  auto work = [&](size_t r, size_t from, size_t to) {
+    deque<U, Chunk2, Policy2> &out = part[r];
+    auto g = [&](auto b, auto e) {
+      for(; b != e; ++b)
+        out.push_back(f(*b));
+      return true;
+    };
+    for(size_t i = from; i < to; i++) {
+      auto b = src.index.map[i];
+      b->chunk->segments(b->chunk->begin(), b->chunk->end(), g);
+    }
+  };
+  run(runs, cut.get(), work);
+  dst.clear();
+  for(size_t r = 0; r < runs; r++)
+    dst.append(std::move(part[r]));
+}
+/**
+ * sort q by comp with up to threads threads.
+ * q is cut by whole chunks into one deque per thread and each is sorted
+ * on its own thread. splitters sampled from the sorted parts then cut
+ * every part into one piece per thread, and thread t merges the t-th
+ * pieces of all parts k-way. the results are linked by append().
+ * the cuts and links only relink chunks (split_at / append), and append
+ * hands the nodes to the receiving deque's pool, so the merges relink
+ * them too.
+ * if comp throws, every element is kept in q in an unspecified order.
+ */
+template<class T, class Chunk, class Policy, class Comp>
+void sort(deque<T, Chunk, Policy> &q, Comp comp, size_t threads = 0) {
+  using DQ = deque<T, Chunk, Policy>;
+  threads = thread_count(threads);
+  std::unique_ptr<size_t[]> cut(new size_t[threads + 1]);
+  size_t runs = cut_runs(q, threads, cut.get()), n = q.size();
+  if(runs < 2) {
+    sjtu::sort(q, comp);
+    return;
+  }
+  //从后往前切 前面的下标不会变
+  std::unique_ptr<size_t[]> start(new size_t[runs]);
+  for(size_t r = 1; r < runs; r++)
+    start[r] = q.index.prefix(cut[r]);
+  std::unique_ptr<DQ[]> part(new DQ[runs]), piece(new DQ[runs * runs]), out(new DQ[runs]);
+  for(size_t r = runs - 1; r > 0; r--)
+    part[r] = q.split_at(start[r]);
+  part[0].swap(q);
+  try {
+    auto sort_part = [&](size_t r, size_t, size_t) { sjtu::sort(part[r], comp); };
+    run(runs, cut.get(), sort_part);
+    //每段取一样多的样本 排好后等间隔取runs-1个分界
+    size_t m = 4 * runs;
+    std::unique_ptr<const T*[]> sample(new const T*[runs * m]);
+    for(size_t r = 0; r < runs; r++) {
+      const DQ &p = part[r];
+      for(size_t i = 0; i < m; i++)
+        sample[r * m + i] = p.empty() ? nullptr : &p[i * p.size() / m];
+    }
+    size_t total = std::remove(sample.get(), sample.get() + runs * m, nullptr) - sample.get();
+    std::sort(sample.get(), sample.get() + total, [&](const T *a, const T *b) { return comp(*a, *b); });
+    //pos[r * runs + t]: part r里不大于第t个分界的元素个数
+    std::unique_ptr<size_t[]> pos(new size_t[runs * runs]);
+    for(size_t r = 0; r < runs; r++) {
+      const DQ &p = part[r];
+      pos[r * runs] = 0;
+      for(size_t t = 1; t < runs; t++) {
+        const T &key = *sample[t * total / runs];
+        size_t lo = pos[r * runs + t - 1], hi = p.size();
+        while(lo < hi) {
+          size_t mid = (lo + hi) / 2;
+          if(comp(key, p[mid]))
+            hi = mid;
+          else
+            lo = mid + 1;
+        }
+        pos[r * runs + t] = lo;
+      }
+    }
+    for(size_t r = 0; r < runs; r++) {
+      for(size_t t = runs - 1; t > 0; t--)
+        piece[r * runs + t] = part[r].split_at(pos[r * runs + t]);
+      piece[r * runs].swap(part[r]);
+    }
+    auto merge_piece = [&](size_t t, size_t, size_t) {
+      for(size_t r = 0; r < runs; r++)
+        out[t].append(std::move(piece[r * runs + t]));
+      out[t].merge_chunks(comp, q.standard_size(n));
+    };
+    run(runs, cut.get(), merge_piece);
+  }catch(...) {
+    for(size_t r = 0; r < runs; r++) {
+      q.append(std::move(part[r]));
+      q.append(std::move(out[r]));
+      for(size_t t = 0; t < runs; t++)
+        q.append(std::move(piece[r * runs + t]));
+    }
+    throw;
+  }
+  for(size_t t = 0; t < runs; t++)
+    q.append(std::move(out[t]));
+}
+template<class T, class Chunk, class Policy>
+void sort(deque<T, Chunk, Policy> &q) {
+  sort(q, [](const T &a, const T &b) { return a < b; });
+}
+
+} // namespace parallel
+
+/**
+ * a lock-free deque for exactly one producer thread and one consumer
+ * thread: the producer pushes at the back, the consumer pops at the front.
+ * elements live in a singly linked list of chunks of Bytes / sizeof(T)
+ * slots. every chunk counts its filled slots with an atomic the producer
+ * stores with release after constructing an element; the consumer loads
+ * it with acquire only when it has used up what it saw last time. the
+ * link to the next chunk is published the same way when a chunk is full.
+ * no locks and no compare-and-swap anywhere, the two ends only meet on
+ * the chunk they both happen to be in.
+ * push_back / emplace_back are for the producer only, front / pop_front /
+ * try_pop_front for the consumer only. size() and empty() may be called
+ * from either side and are exact only when the other side is idle.
+ */
+template<class T, size_t Bytes = 4096> class spsc_deque{
+  public:
+    static constexpr size_t line = 64;
+    static constexpr size_t cap = Bytes / sizeof(T) > 0 ? Bytes / sizeof(T) : 1;
+    struct chunk{
+      std::atomic<size_t> filled;
+      std::atomic<chunk*> next;
+      alignas(T) unsigned char storage[cap * sizeof(T)];
+      chunk() : filled(0), next(nullptr) {}
+      T *at(size_t i) { return reinterpret_cast<T*>(storage) + i; }
+    };
+    //生产者和消费者的字段放在不同的缓存行 不互相抢
+    struct alignas(line) producer_side{
+      chunk *tail;
+      size_t pos;
+      std::atomic<size_t> pushed;
+    };
+    struct alignas(line) consumer_side{
+      chunk *head;
+      size_t pos, seen;
+      std::atomic<size_t> popped;
+    };
+    producer_side prod;
+    consumer_side cons;
+    //消费者用完的块留一个给生产者 只有消费者从空写成非空 只有生产者从非空写成空
+    alignas(line) std::atomic<chunk*> spare;
+    // --------------------------
+    spsc_deque() : spare(nullptr) {
+      chunk *c = new chunk();
+      prod.tail = cons.head = c;
+      prod.pos = cons.pos = cons.seen = 0;
+      prod.pushed.store(0, std::memory_order_relaxed);
+      cons.popped.store(0, std::memory_order_relaxed);
+    }
+    spsc_deque(const spsc_deque &) = delete;
+    spsc_deque &operator=(const spsc_deque &) = delete;
+    ~spsc_deque() {
+      chunk *c = cons.head;
+      size_t i = cons.pos;
+      while(c) {
+        size_t f = c->filled.load(std::memory_order_acquire);
+        for(; i < f; i++)
+          c->at(i)->~T();
+        chunk *tmp = c;
+        c = c->next.load(std::memory_order_acquire);
+        delete tmp;
+        i = 0;
+      }
+      delete spare.load(std::memory_order_acquire);
+    }
+    /**
+     * producer: construct an element at the back.
+     */
+    template<class... Args> void emplace_back(Args&&... args) {
+      if(prod.pos == cap) {
+        chunk *c = spare.load(std::memory_order_acquire);
+        if(c)
+          spare.store(nullptr, std::memory_order_relaxed);
+        else
+          c = new chunk();
+        prod.tail->next.store(c, std::memory_order_release);
+        prod.tail = c;
+        prod.pos = 0;
+      }
+      new(prod.tail->at(prod.pos)) T(std::forward<Args>(args)...);
+      prod.tail->filled.store(++prod.pos, std::memory_order_release);
+      prod.pushed.store(prod.pushed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    void push_back(const T &value) { emplace_back(value); }
+    void push_back(T &&value) { emplace_back(std::move(value)); }
+    /**
+     * consumer: the first element, or nullptr if nothing has arrived.
+     */
+    T *peek() {
+      if(cons.pos == cons.seen) {
+        cons.seen = cons.head->filled.load(std::memory_order_acquire);
+        if(cons.pos == cons.seen) {
+          if(cons.pos < cap)
+            return nullptr;
+          //这块读完了 生产者接上下一块才能走
+          chunk *n = cons.head->next.load(std::memory_order_acquire);
+          if(!n)
+            return nullptr;
+          recycle(cons.head);
+          cons.head = n;
+          cons.pos = 0;
+          cons.seen = n->filled.load(std::memory_order_acquire);
+          if(cons.seen == 0)
+            return nullptr;
+        }
+      }
+      return cons.head->at(cons.pos);
+    }
+    void recycle(chunk *c) {
+      c->filled.store(0, std::memory_order_relaxed);
+      c->next.store(nullptr, std::memory_order_relaxed);
+      if(spare.load(std::memory_order_relaxed) == nullptr)
+        spare.store(c, std::memory_order_release);
+      else
+        delete c;
+    }
+    //peek()之后把第一个元素去掉
+    void drop() {
+      cons.head->at(cons.pos)->~T();
+      cons.pos++;
+      cons.popped.store(cons.popped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    /**
+     * consumer: throw container_is_empty if nothing has arrived.
+     */
+    T &front() {
+      T *p = peek();
+      if(!p)
+        throw container_is_empty();
+      return *p;
+    }
+    void pop_front() {
+      if(!peek())
+        throw container_is_empty();
+      drop();
+    }
+    /**
+     * consumer: move the first element into out and pop it,
+     * return false if nothing has arrived.
+     */
+    bool try_pop_front(T &out) {
+      T *p = peek();
+      if(!p)
+        return false;
+      out = std::move(*p);
+      drop();
+      return true;
+    }
+    size_t size() const {
+      size_t out = cons.popped.load(std::memory_order_acquire);
+      size_t in = prod.pushed.load(std::memory_order_acquire);
+      return in > out ? in - out : 0;
+    }
+    bool empty() const { return size() == 0; }
+};
+
+/**
+ * a Chase-Lev work-stealing deque: the owner thread pushes and pops at the
+ * back without locks, any number of thieves steal from the front, one CAS
+ * on top per steal (and one in pop_back when it races for the last
+ * element).
+ * the ring is a directory of chunks of 2^k slots. when it is full a
+ * directory twice as long is made that points at the old chunks, so the
+ * elements stay where they are. the chunk holding both ends, if the live
+ * range doesn't start on a chunk boundary, is not reused: the new
+ * directory would write other indices into slots the old one still maps
+ * to live ones, so its two parts are copied into fresh chunks. old
+ * directories and the chunks only they point at stay alive until the
+ * deque is destroyed because a thief may still be reading one.
+ * thieves read a slot before they know it is theirs, so T must be
+ * trivially copyable, e.g. a task pointer.
+ */
+template<class T, size_t Bytes = 4096> class steal_deque{
+  public:
+    static_assert(std::is_trivially_copyable<T>::value, "steal_deque needs a trivially copyable T");
+    using index_type = std::ptrdiff_t;
+    static constexpr size_t line = 64;
+    //块长取不超过Bytes/sizeof(T)的2的幂
+    static constexpr size_t floor_pow2(size_t n) { return n <= 1 ? 1 : 2 * floor_pow2(n / 2); }
+    static constexpr size_t cap = floor_pow2(Bytes / sizeof(T));
+    struct chunk{
+      std::atomic<T> slot[cap];
+    };
+    struct ring{
+      size_t chunks;
+      chunk **dir;
+      ring *prev;
+      //grow时换下来的块 只有prev还指着它
+      chunk *retired;
+      ring(size_t chunks_, ring *prev_) : chunks(chunks_), dir(new chunk*[chunks_]()), prev(prev_), retired(nullptr) {}
+      ~ring() { delete [] dir; }
+      std::atomic<T> &at(index_type i) const {
+        return dir[size_t(i) / cap & (chunks - 1)]->slot[size_t(i) & (cap - 1)];
+      }
+      size_t capacity() const { return chunks * cap; }
+    };
+    alignas(line) std::atomic<index_type> top;
+    alignas(line) std::atomic<index_type> bottom;
+    std::atomic<ring*> array;
+    // --------------------------
+    steal_deque() : top(0), bottom(0) {
+      ring *r = new ring(2, nullptr);
+      for(size_t k = 0; k < r->chunks; k++)
+        r->dir[k] = new chunk();
+      array.store(r, std::memory_order_relaxed);
+    }
+    steal_deque(const steal_deque &) = delete;
+    steal_deque &operator=(const steal_deque &) = delete;
+    ~steal_deque() {
+      ring *r = array.load(std::memory_order_relaxed);
+      //旧目录里的块要么还在最新的目录里 要么是某次grow换下来的retired
+      for(size_t k = 0; k < r->chunks; k++)
+        delete r->dir[k];
+      while(r) {
+        ring *tmp = r;
+        r = r->prev;
+        delete tmp->retired;
+        delete tmp;
+      }
+    }
+    /**
+     * owner: double the directory, live range [t, b) is full.
+     */
+    ring *grow(ring *old, index_type t, index_type b) {
+      ring *r = new ring(old->chunks * 2, old);
+      size_t first = size_t(t) / cap, last = size_t(b - 1) / cap;
+      //头尾在同一块: 两段各自搬到新块 这块留给旧目录
+      chunk *both = last - first == old->chunks ? old->dir[first & (old->chunks - 1)] : nullptr;
+      try {
+        for(size_t k = first; k <= last; k++) {
+          chunk *c = old->dir[k & (old->chunks - 1)];
+          if(c == both) {
+            chunk *n = new chunk();
+            index_type from = std::max(t, index_type(k * cap)), to = std::min(b, index_type((k + 1) * cap));
+            for(index_type i = from; i < to; i++)
+              n->slot[size_t(i) & (cap - 1)].store(c->slot[size_t(i) & (cap - 1)].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            c = n;
+          }
+          r->dir[k & (r->chunks - 1)] = c;
+        }
+        for(size_t k = 0; k < r->chunks; k++)
+          if(!r->dir[k])
+            r->dir[k] = new chunk();
+      }catch(...) {
+        //只删新开的块
+        for(size_t k = 0; k < r->chunks; k++) {
+          bool reused = false;
+          for(size_t j = 0; j < old->chunks; j++)
+            reused |= r->dir[k] == old->dir[j];
+          if(!reused)
+            delete r->dir[k];
+        }
+        r->prev = nullptr;
+        delete r;
+        throw;
+      }
+      r->retired = both;
+      array.store(r, std::memory_order_release);
+      return r;
+    }
+    /**
+     * owner: add x at the back.
+     */
+    void push_back(const T &x) {
+      index_type b = bottom.load(std::memory_order_relaxed);
+      index_type t = top.load(std::memory_order_acquire);
+      ring *r = array.load(std::memory_order_relaxed);
+      if(size_t(b - t) >= r->capacity())
+        r = grow(r, t, b);
+      r->at(b).store(x, std::memory_order_relaxed);
+      bottom.store(b + 1, std::memory_order_release);
+    }
+    /**
+     * owner: take the last element into out, false if there is none.
+     */
+    bool try_pop_back(T &out) {
+      index_type b = bottom.load(std::memory_order_relaxed) - 1;
+      ring *r = array.load(std::memory_order_relaxed);
+      bottom.store(b, std::memory_order_seq_cst);
+      index_type t = top.load(std::memory_order_seq_cst);
+      if(t > b) {
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return false;
+      }
+      out = r->at(b).load(std::memory_order_relaxed);
+      if(t < b)
+        return true;
+      //只剩一个 和小偷抢
+      bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      bottom.store(b + 1, std::memory_order_relaxed);
+      return won;
+    }
+    /**
+     * thief: take the first element into out. false if the deque is empty
+     * or another thread got it first; the caller may just try again.
+     */
+    bool steal(T &out) {
+      index_type t = top.load(std::memory_order_seq_cst);
+      index_type b = bottom.load(std::memory_order_seq_cst);
+      if(t >= b)
+        return false;
+      ring *r = array.load(std::memory_order_acquire);
+      T x = r->at(t).load(std::memory_order_relaxed);
+      if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return false;
+      out = x;
+      return true;
+    }
+    //别的线程在动时只是近似值
+    size_t size() const {
+      index_type b = bottom.load(std::memory_order_acquire);
+      index_type t = top.load(std::memory_order_acquire);
+      return b > t ? size_t(b - t) : 0;
+    }
+    bool empty() const { return size() == 0; }
+};
+
+/**
+ * a deque any number of threads may push and pop at both ends.
+ * the elements are in a doubly linked list of chunks of Bytes / sizeof(T)
+ * slots, every chunk holds [lo, hi) and none is empty unless it is the
+ * only one. the front and the back have a lock each; an operation at one
+ * end takes only that lock while the ends are in different chunks:
+ *   staying in its chunk or adding one: two chunks or more
+ *   dropping its chunk:                 three chunks or more
+ * the other end can then never reach the chunk being used. anything else
+ * (one or two chunks left, insert / erase in the middle) takes the
+ * structural lock and then both end locks.
+ * pops are try_pop_* returning false when empty, a separate empty() check
+ * would be stale by the time of the pop. size() is exact only when no
+ * other thread is working.
+ */
+template<class T, size_t Bytes = 4096> class concurrent_deque{
+  public:
+    static constexpr size_t line = 64;
+    static constexpr size_t cap = Bytes / sizeof(T) > 1 ? Bytes / sizeof(T) : 2;
+    struct chunk{
+      chunk *pre, *next;
+      size_t lo, hi;
+      alignas(T) unsigned char storage[cap * sizeof(T)];
+      chunk(size_t at) : pre(nullptr), next(nullptr), lo(at), hi(at) {}
+      T *at(size_t i) { return reinterpret_cast<T*>(storage) + i; }
+      size_t size() const { return hi - lo; }
+    };
+    //临界区很短 自旋 抢不到就让出
+    struct spin_lock{
+      std::atomic_flag busy = ATOMIC_FLAG_INIT;
+      void lock() {
+        while(busy.test_and_set(std::memory_order_acquire))
+          std::this_thread::yield();
+      }
+      void unlock() { busy.clear(std::memory_order_release); }
+    };
+    struct guard{
+      spin_lock &l;
+      explicit guard(spin_lock &l_) : l(l_) { l.lock(); }
+      ~guard() { l.unlock(); }
+    };
+    struct alignas(line) end_side{
+      spin_lock lock;
+      chunk *c;
+      //这一端净放进去的个数 两端加起来是size
+      std::atomic<std::ptrdiff_t> net;
+      void add(std::ptrdiff_t d) { net.store(net.load(std::memory_order_relaxed) + d, std::memory_order_relaxed); }
+    };
+    end_side front_end, back_end;
+    alignas(line) spin_lock structure;
+    std::atomic<size_t> chunks;
+    // --------------------------
+    concurrent_deque() : chunks(1) {
+      chunk *c = new chunk(cap / 2);
+      front_end.c = back_end.c = c;
+      front_end.net.store(0, std::memory_order_relaxed);
+      back_end.net.store(0, std::memory_order_relaxed);
+    }
+    concurrent_deque(const concurrent_deque &) = delete;
+    concurrent_deque &operator=(const concurrent_deque &) = delete;
+    ~concurrent_deque() {
+      chunk *c = front_end.c;
+      while(c) {
+        for(size_t i = c->lo; i < c->hi; i++)
+          c->at(i)->~T();
+        chunk *tmp = c;
+        c = c->next;
+        delete tmp;
+      }
+    }
+    //结构锁 先结构再前后 顺序固定不会死锁
+    struct whole{
+      concurrent_deque *q;
+      explicit whole(concurrent_deque *q_) : q(q_) {
+        q->structure.lock();
+        q->front_end.lock.lock();
+        q->back_end.lock.lock();
+      }
+      ~whole() {
+        q->back_end.lock.unlock();
+        q->front_end.lock.unlock();
+        q->structure.unlock();
+      }
+    };
+    bool can_stay() const { return chunks.load(std::memory_order_acquire) >= 2; }
+    bool can_drop() const { return chunks.load(std::memory_order_acquire) >= 3; }
+    /**
+     * the put / take below assume the caller may touch the end they work on.
+     */
+    template<class... Args> void put_back(Args&&... args) {
+      chunk *c = back_end.c;
+      if(c->hi == cap) {
+        chunk *n = new chunk(0);
+        try {
+          new(n->at(0)) T(std::forward<Args>(args)...);
+        }catch(...) {
+          delete n;
+          throw;
+        }
+        n->hi = 1;
+        n->pre = c;
+        c->next = n;
+        back_end.c = n;
+        chunks.fetch_add(1, std::memory_order_release);
+      }else {
+        new(c->at(c->hi)) T(std::forward<Args>(args)...);
+        c->hi++;
+      }
+      back_end.add(1);
+    }
+    template<class... Args> void put_front(Args&&... args) {
+      chunk *c = front_end.c;
+      if(c->lo == 0) {
+        chunk *n = new chunk(cap);
+        try {
+          new(n->at(cap - 1)) T(std::forward<Args>(args)...);
+        }catch(...) {
+          delete n;
+          throw;
+        }
+        n->lo = cap - 1;
+        n->next = c;
+        c->pre = n;
+        front_end.c = n;
+        chunks.fetch_add(1, std::memory_order_release);
+      }else {
+        new(c->at(c->lo - 1)) T(std::forward<Args>(args)...);
+        c->lo--;
+      }
+      front_end.add(1);
+    }
+    //拿走之后块空了 只剩这一块就放回中间 否则摘掉
+    void drop_if_empty(chunk *c) {
+      if(c->lo != c->hi)
+        return;
+      if(!c->pre && !c->next) {
+        c->lo = c->hi = cap / 2;
+        return;
+      }
+      if(c->pre)
+        c->pre->next = c->next;
+      else
+        front_end.c = c->next;
+      if(c->next)
+        c->next->pre = c->pre;
+      else
+        back_end.c = c->pre;
+      chunks.fetch_sub(1, std::memory_order_release);
+      delete c;
+    }
+    bool take_back(T &out) {
+      chunk *c = back_end.c;
+      if(c->lo == c->hi)
+        return false;
+      out = std::move(*c->at(c->hi - 1));
+      c->at(--c->hi)->~T();
+      back_end.add(-1);
+      drop_if_empty(c);
+      return true;
+    }
+    bool take_front(T &out) {
+      chunk *c = front_end.c;
+      if(c->lo == c->hi)
+        return false;
+      out = std::move(*c->at(c->lo));
+      c->at(c->lo++)->~T();
+      front_end.add(-1);
+      drop_if_empty(c);
+      return true;
+    }
+    void push_back(const T &value) { emplace_back(value); }
+    void push_back(T &&value) { emplace_back(std::move(value)); }
+    void push_front(const T &value) { emplace_front(value); }
+    void push_front(T &&value) { emplace_front(std::move(value)); }
+    template<class... Args> void emplace_back(Args&&... args) {
+      {
+        guard g(back_end.lock);
+        if(can_stay()) {
+          put_back(std::forward<Args>(args)...);
+          return;
+        }
+      }
+      whole w(this);
+      put_back(std::forward<Args>(args)...);
+    }
+    template<class... Args> void emplace_front(Args&&... args) {
+      {
+        guard g(front_end.lock);
+        if(can_stay()) {
+          put_front(std::forward<Args>(args)...);
+          return;
+        }
+      }
+      whole w(this);
+      put_front(std::forward<Args>(args)...);
+    }
+    /**
+     * move the last element into out and remove it,
+     * return false if the deque is empty.
+     */
+    bool try_pop_back(T &out) {
+      {
+        guard g(back_end.lock);
+        chunk *c = back_end.c;
+        //拿完不会摘块 或者摘了也碰不到另一头
+        if(c->size() > 1 ? can_stay() : can_drop())
+          return take_back(out);
+      }
+      whole w(this);
+      return take_back(out);
+    }
+    bool try_pop_front(T &out) {
+      {
+        guard g(front_end.lock);
+        chunk *c = front_end.c;
+        if(c->size() > 1 ? can_stay() : can_drop())
+          return take_front(out);
+      }
+      whole w(this);
+      return take_front(out);
+    }
+    /**
+     * the chunk holding the pos-th element, pos becomes the slot in it.
+     * pos must be less than the size.
+     */
+    chunk *find(size_t &pos) const {
+      chunk *c = front_end.c;
+      while(pos >= c->size()) {
+        pos -= c->size();
+        c = c->next;
+      }
+      pos += c->lo;
+      return c;
+    }
+    /**
+     * insert value before the pos-th element, O(n / chunk) under the
+     * structural lock. throw index_out_of_bound if pos > size().
+     */
+    void insert(size_t pos, const T &value) {
+      whole w(this);
+      size_t n = unlocked_size();
+      if(pos > n)
+        throw index_out_of_bound();
+      if(pos == n) {
+        put_back(value);
+        return;
+      }
+      if(pos == 0) {
+        put_front(value);
+        return;
+      }
+      T tmp(value);
+      chunk *c = find(pos);
+      if(c->lo == 0 && c->hi == cap) {
+        //满了 后一半挪到新块
+        chunk *m = new chunk(0);
+        size_t mid = cap / 2;
+        for(size_t i = mid; i < cap; i++) {
+          new(m->at(i - mid)) T(std::move(*c->at(i)));
+          c->at(i)->~T();
+        }
+        m->hi = cap - mid;
+        c->hi = mid;
+        m->pre = c;
+        m->next = c->next;
+        if(c->next)
+          c->next->pre = m;
+        else
+          back_end.c = m;
+        c->next = m;
+        chunks.fetch_add(1, std::memory_order_release);
+        if(pos >= mid) {
+          pos -= mid;
+          c = m;
+        }
+      }
+      if(c->hi < cap) {
+        new(c->at(c->hi)) T(std::move(*c->at(c->hi - 1)));
+        std::move_backward(c->at(pos), c->at(c->hi - 1), c->at(c->hi));
+        c->hi++;
+        *c->at(pos) = std::move(tmp);
+      }else {
+        new(c->at(c->lo - 1)) T(std::move(*c->at(c->lo)));
+        std::move(c->at(c->lo + 1), c->at(pos), c->at(c->lo));
+        c->lo--;
+        *c->at(pos - 1) = std::move(tmp);
+      }
+      front_end.add(1);
+    }
+    /**
+     * remove the pos-th element under the structural lock, merging its
+     * chunk with the next one when both fit in one.
+     * throw index_out_of_bound if pos >= size().
+     */
+    void erase(size_t pos) {
+      whole w(this);
+      if(pos >= unlocked_size())
+        throw index_out_of_bound();
+      chunk *c = find(pos);
+      std::move(c->at(pos + 1), c->at(c->hi), c->at(pos));
+      c->at(--c->hi)->~T();
+      front_end.add(-1);
+      chunk *n = c->next;
+      if(c->lo != c->hi && n && c->hi + n->size() <= cap) {
+        for(size_t i = n->lo; i < n->hi; i++) {
+          new(c->at(c->hi)) T(std::move(*n->at(i)));
+          c->hi++;
+          n->at(i)->~T();
+        }
+        n->lo = n->hi;
+        drop_if_empty(n);
+      }
+      drop_if_empty(c);
+    }
+    size_t unlocked_size() const {
+      std::ptrdiff_t n = front_end.net.load(std::memory_order_acquire) + back_end.net.load(std::memory_order_acquire);
+      return n > 0 ? size_t(n) : 0;
+    }
+    size_t size() const { return unlocked_size(); }
+    bool empty() const { return size() == 0; }
+};
+
+/**
+ * a deque of at most Capacity elements kept inside the object, so it
+ * never allocates. when it is full push_* throws runtime_error, or with
+ * Overwrite drops the element at the other end (the oldest one for a log
+ * fed by push_back).
+ * element i is at slot (start + i) % Capacity; iterators hold start + i,
+ * so unlike deque they stay valid when other elements are pushed or popped
+ * at the ends.
+ */
+template<class T, size_t Capacity, bool Overwrite = false> class ring_deque{
+  public:
+    static_assert(Capacity > 0, "ring_deque needs a positive Capacity");
+    //从中间开始编号 往前push也不会绕回0
+    static constexpr size_t origin = std::size_t(-1) / 2 / Capacity * Capacity;
+    alignas(T) unsigned char storage[Capacity * sizeof(T)];
+    size_t start, n;
+    T *slot(size_t seq) { return reinterpret_cast<T*>(storage) + seq % Capacity; }
+    const T *slot(size_t seq) const { return reinterpret_cast<const T*>(storage) + seq % Capacity; }
+    //------------------------------
+    template<bool Const> class basic_iterator{
+      public:
+        using owner_type = typename std::conditional<Const, const ring_deque, ring_deque>::type;
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = typename std::conditional<Const, const T*, T*>::type;
+        using reference = typename std::conditional<Const, const T&, T&>::type;
+        owner_type *q;
+        size_t seq;
+        //--------------------------
+        basic_iterator() : q(nullptr), seq(0) {}
+        basic_iterator(owner_type *q_, size_t seq_) : q(q_), seq(seq_) {}
+        //iterator能转成const_iterator
+        template<bool C, class = typename std::enable_if<Const && !C>::type>
+        basic_iterator(const basic_iterator<C> &other) : q(other.q), seq(other.seq) {}
+        /**
+         * move n elements, throw index_out_of_bound when leaving
+         * [begin(), end()].
+         */
+        basic_iterator operator+(const int &n) const {
+          if(!q)
+            throw invalid_iterator();
+          size_t to = seq + n;
+          if(to - q->start > q->n)
+            throw index_out_of_bound();
+          return basic_iterator(q, to);
+        }
+        basic_iterator operator-(const int &n) const {
+          return *this + (-n);
+        }
+        int operator-(const basic_iterator &rhs) const {
+          if(q != rhs.q)
+            throw invalid_iterator();
+          return int(std::ptrdiff_t(seq - rhs.seq));
+        }
+        basic_iterator &operator+=(const int &n) { return *this = *this + n; }
+        basic_iterator &operator-=(const int &n) { return *this = *this - n; }
+        basic_iterator operator++(int) {
+          basic_iterator old = *this;
+          *this = *this + 1;
+          return old;
+        }
+        basic_iterator &operator++() { return *this = *this + 1; }
+        basic_iterator operator--(int) {
+          basic_iterator old = *this;
+          *this = *this - 1;
+          return old;
+        }
+        basic_iterator &operator--() { return *this = *this - 1; }
+        reference operator*() const { return *q->slot(seq); }
+        pointer operator->() const noexcept { return q->slot(seq); }
+        reference operator[](const int &n) const { return *(*this + n); }
+        bool operator<(const basic_iterator &rhs) const {
+          if(q != rhs.q)
+            throw invalid_iterator();
+          return std::ptrdiff_t(seq - rhs.seq) < 0;
+        }
+        bool operator>(const basic_iterator &rhs) const { return rhs < *this; }
+        bool operator<=(const basic_iterator &rhs) const { return !(rhs < *this); }
+        bool operator>=(const basic_iterator &rhs) const { return !(*this < rhs); }
+        template<bool C> bool operator==(const basic_iterator<C> &rhs) const { return q == rhs.q && seq == rhs.seq; }
+        template<bool C> bool operator!=(const basic_iterator<C> &rhs) const { return !(*this == rhs); }
+    };
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+    //------------------------------
+    ring_deque() : start(origin), n(0) {}
+    ring_deque(const ring_deque &other) : start(origin), n(0) {
+      for(size_t i = 0; i < other.n; i++)
+        push_back(*other.slot(other.start + i));
+    }
+    ring_deque &operator=(const ring_deque &other) {
+      if(this == &other)
+        return *this;
+      clear();
+      for(size_t i = 0; i < other.n; i++)
+        push_back(*other.slot(other.start + i));
+      return *this;
+    }
+    ~ring_deque() { clear(); }
+    static constexpr size_t capacity() { return Capacity; }
+    size_t size() const { return n; }
+    bool empty() const { return n == 0; }
+    bool full() const { return n == Capacity; }
+    void clear() {
+      for(; n > 0; n--, start++)
+        slot(start)->~T();
+      start = origin;
+    }
+    /**
+     * access a specified element with bound checking.
+     * throw index_out_of_bound if out of bound.
+     */
+    T &at(const size_t &pos) {
+      if(pos >= n)
+        throw index_out_of_bound();
+      return *slot(start + pos);
+    }
+    const T &at(const size_t &pos) const {
+      if(pos >= n)
+        throw index_out_of_bound();
+      return *slot(start + pos);
+    }
+    T &operator[](const size_t &pos) { return at(pos); }
+    const T &operator[](const size_t &pos) const { return at(pos); }
+    /**
+     * throw container_is_empty when the container is empty.
+     */
+    const T &front() const {
+      if(n == 0)
+        throw container_is_empty();
+      return *slot(start);
+    }
+    const T &back() const {
+      if(n == 0)
+        throw container_is_empty();
+      return *slot(start + n - 1);
+    }
+    iterator begin() { return iterator(this, start); }
+    iterator end() { return iterator(this, start + n); }
+    const_iterator begin() const { return cbegin(); }
+    const_iterator end() const { return cend(); }
+    const_iterator cbegin() const { return const_iterator(this, start); }
+    const_iterator cend() const { return const_iterator(this, start + n); }
+    /**
+     * full and not Overwrite: throw runtime_error, nothing changes.
+     * full and Overwrite: the element at the front (back) is dropped.
+     */
+    template<class... Args> void emplace_back(Args&&... args) {
+      make_room(std::integral_constant<bool, Overwrite>(), std::true_type(), std::forward<Args>(args)...);
+    }
+    template<class... Args> void emplace_front(Args&&... args) {
+      make_room(std::integral_constant<bool, Overwrite>(), std::false_type(), std::forward<Args>(args)...);
+    }
+    void push_back(const T &value) { emplace_back(value); }
+    void push_back(T &&value) { emplace_back(std::move(value)); }
+    void push_front(const T &value) { emplace_front(value); }
+    void push_front(T &&value) { emplace_front(std::move(value)); }
+    template<class... Args> void make_room(std::false_type, std::true_type, Args&&... args) {
+      if(n == Capacity)
+        throw runtime_error();
+      new(slot(start + n)) T(std::forward<Args>(args)...);
+      n++;
+    }
+    template<class... Args> void make_room(std::false_type, std::false_type, Args&&... args) {
+      if(n == Capacity)
+        throw runtime_error();
+      new(slot(start - 1)) T(std::forward<Args>(args)...);
+      start--;
+      n++;
+    }
+    //满了先造好新元素再挤掉另一头 构造抛异常时什么都不丢
+    template<class Back, class... Args> void make_room(std::true_type, Back back, Args&&... args) {
+      if(n < Capacity) {
+        make_room(std::false_type(), back, std::forward<Args>(args)...);
+        return;
+      }
+      T tmp(std::forward<Args>(args)...);
+      if(back)
+        pop_front();
+      else
+        pop_back();
+      make_room(std::false_type(), back, std::move(tmp));
+    }
+    /**
+     * throw container_is_empty when the container is empty.
+     */
+    void pop_back() {
+      if(n == 0)
+        throw container_is_empty();
+      slot(start + n - 1)->~T();
+      n--;
+    }
+    void pop_front() {
+      if(n == 0)
+        throw container_is_empty();
+      slot(start)->~T();
+      start++;
+      n--;
+    }
 };
 
 } // namespace sjtu
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,153 @@
+// chunk sizing policies, for both chunk types
+
+#include <iostream>
+#include <deque>
+
+#include "deque.hpp"
+
+static const int N = 30000;
+
+template <typename Ans, typename Test>
+bool isEqual(Ans &ans, Test &test) {
+    if (ans.size() != test.size())
+        return false;
+    for (int i = 0; i < (int)ans.size(); i++)
+        if (ans[i] != test[i]) return false;
+    return true;
+}
+
+// no chunk longer than the policy allows (a push fills one to
+// standard_size() + 1), none empty
+template <typename Q>
+bool chunksFit(Q &q) {
+    for (size_t i = q.index.lo; i < q.index.hi; i++) {
+        size_t s = q.index.map[i]->size();
+        if (s == 0 || s > q.split_size() + 1) return false;
+    }
+    return true;
+}
+
+template <typename Q>
+bool randomTest() {
+    std::deque<int> a;
+    Q b;
+    unsigned seed = 2333;
+    for (int i = 0; i < N; i++) {
+        seed = seed * 1103515245 + 12345;
+        int x = seed >> 8;
+        size_t pos = a.empty() ? 0 : x % a.size();
+        switch (x % 8) {
+        case 0: case 1: a.push_back(x); b.push_back(x); break;
+        case 2: a.push_front(x); b.push_front(x); break;
+        case 3: a.insert(a.begin() + pos, x); b.insert(b.begin() + pos, x); break;
+        case 4: if (!a.empty()) { a.erase(a.begin() + pos); b.erase(b.begin() + pos); } break;
+        case 5: if (!a.empty()) { a.pop_front(); b.pop_front(); } break;
+        case 6: if (!a.empty()) { a[pos] = x; b[pos] = x; } break;
+        default: a.insert(a.begin() + pos, 3, x); b.insert(b.begin() + pos, 3, x);
+        }
+        if (i % 1000 == 0 && !chunksFit(b)) return false;
+    }
+    return isEqual(a, b) && chunksFit(b);
+}
+
+// a deque of at most small elements stays in one chunk
+template <typename Q>
+bool smallTest() {
+    Q b;
+    size_t small = b.sizing.small;
+    for (size_t i = 0; i < small; i++) {
+        if (i % 2) b.push_back(i);
+        else b.push_front(i);
+        if (b.index.count() != 1) return false;
+    }
+    b.insert(b.begin() + small / 2, small + 1, 7);
+    if (b.index.count() < 2) return false;
+    b.erase(b.begin() + 1, b.end() - 1);
+    return b.size() == 2 && b.index.count() == 1;
+}
+
+// a fixed policy keeps its target whatever the size
+template <typename Q>
+bool fixedTest() {
+    Q b;
+    size_t target = b.sizing.target;
+    for (int i = 0; i < N; i++) b.push_back(i);
+    if (b.sizing.target != target || b.standard_size(N) != target) return false;
+    for (size_t i = b.index.lo + 1; i + 1 < b.index.hi; i++)
+        if (b.index.map[i]->size() > b.sizing.split) return false;
+    return chunksFit(b);
+}
+
+// a full chunk of an aligned policy takes whole units
+template <typename Q, size_t Align>
+bool alignedTest() {
+    Q b;
+    for (int i = 0; i < N; i++) {
+        b.push_back(i);
+        if (b.sizing.target * sizeof(int) % Align != 0) return false;
+    }
+    return b.sizing.small * sizeof(int) % Align == 0 && chunksFit(b);
+}
+
+template <typename T, typename Policy>
+using ListDeque = sjtu::deque<T, sjtu::double_list<T>, Policy>;
+template <typename T, typename Policy>
+using ArrayDeque = sjtu::deque<T, sjtu::circular_array<T>, Policy>;
+
+bool sqrtTest() {
+    return randomTest<ListDeque<int, sjtu::sqrt_policy>>() && randomTest<ArrayDeque<int, sjtu::sqrt_policy>>()
+        && smallTest<ListDeque<int, sjtu::sqrt_policy>>() && smallTest<ArrayDeque<int, sjtu::sqrt_policy>>();
+}
+bool fixedBytesTest() {
+    typedef sjtu::fixed_bytes_policy<256> P;
+    return randomTest<ListDeque<int, P>>() && randomTest<ArrayDeque<int, P>>()
+        && smallTest<ListDeque<int, P>>() && smallTest<ArrayDeque<int, P>>()
+        && fixedTest<ListDeque<int, P>>() && fixedTest<ArrayDeque<int, P>>();
+}
+bool cacheLineTest() {
+    typedef sjtu::cache_line_policy P;
+    return randomTest<ListDeque<int, P>>() && randomTest<ArrayDeque<int, P>>()
+        && smallTest<ArrayDeque<int, P>>() && alignedTest<ArrayDeque<int, P>, 64>();
+}
+bool pageTest() {
+    typedef sjtu::page_policy P;
+    return randomTest<ListDeque<int, P>>() && randomTest<ArrayDeque<int, P>>()
+        && smallTest<ArrayDeque<int, P>>() && alignedTest<ArrayDeque<int, P>, 4096>();
+}
+// a chunk of one element for a type bigger than the fixed size
+bool hugeElementTest() {
+    struct Big { int a[100]; };
+    ListDeque<Big, sjtu::fixed_bytes_policy<64>> b;
+    for (int i = 0; i < 100; i++) b.push_back(Big{{i}});
+    for (int i = 0; i < 100; i++)
+        if (b[i].a[0] != i) return false;
+    return b.sizing.target == 1 && chunksFit(b);
+}
+
+int main() {
+    bool (*testFunc[])() = {
+        sqrtTest, fixedBytesTest, cacheLineTest, pageTest, hugeElementTest,
+    };
+    const char *testMessage[] = {
+        "Testing sqrt_policy...", "Testing fixed_bytes_policy...", "Testing cache_line_policy...", "Testing page_policy...",
+        "Testing elements larger than a chunk...",
+    };
+
+    bool error = false;
+    for (int i = 0; i < (int)(sizeof(testFunc) / sizeof(testFunc[0])); i++) {
+        printf("%-45s", testMessage[i]);
+        if (testFunc[i]())
+            printf("Passed\n");
+        else {
+            error = true;
+            printf("Failed !!!\n");
+        }
+    }
+
+    if (error)
+        printf("\nUnfortunately, you failed in this test\n\a");
+    else
+        printf("\nCongratulations, your deque passed all the tests!\n");
+
+    return 0;
+}
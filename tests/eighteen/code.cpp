@@ -0,0 +1,169 @@
+// sjtu::sort and parallel::sort, for both chunk types
+
+#include <iostream>
+#include <deque>
+#include <algorithm>
+#include <functional>
+
+#include "deque.hpp"
+
+static const int N = 200000;
+
+typedef sjtu::deque<int, sjtu::double_list<int>> ListDeque;
+typedef sjtu::deque<int, sjtu::circular_array<int>> ArrayDeque;
+
+template <typename Ans, typename Test>
+bool isEqual(Ans &ans, Test &test) {
+    if (ans.size() != test.size())
+        return false;
+    for (int i = 0; i < (int)ans.size(); i++)
+        if (ans[i] != test[i]) return false;
+    return true;
+}
+
+// pushed at both ends and through the middle, so the chunks have all
+// kinds of lengths before the sort
+template <typename Q>
+void build(std::deque<int> &a, Q &b, int n, int range) {
+    unsigned seed = 998244353;
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1103515245 + 12345;
+        int x = (seed >> 8) % range;
+        if (i % 3 == 0) { a.push_front(x); b.push_front(x); }
+        else if (i % 3 == 1) { a.push_back(x); b.push_back(x); }
+        else { a.insert(a.begin() + x % a.size(), x); b.insert(b.begin() + x % b.size(), x); }
+    }
+}
+
+// the chunks are balanced again afterwards
+template <typename Q>
+bool chunksFit(Q &q) {
+    for (size_t i = q.index.lo; i < q.index.hi; i++) {
+        size_t s = q.index.map[i]->size();
+        if (s == 0 || s > q.split_size() + 1) return false;
+    }
+    return true;
+}
+
+// threads == 0 is sjtu::sort, anything else parallel::sort
+template <typename Q, typename Comp>
+void sortBy(Q &q, Comp comp, size_t threads) {
+    if (threads == 0) sjtu::sort(q, comp);
+    else sjtu::parallel::sort(q, comp, threads);
+}
+
+template <typename Q>
+bool randomTest(size_t threads) {
+    for (int n : {0, 1, 2, 17, 1000, N}) {
+        std::deque<int> a;
+        Q b;
+        build(a, b, n, 1000000007);
+        sortBy(b, std::less<int>(), threads);
+        std::sort(a.begin(), a.end());
+        if (!isEqual(a, b) || !chunksFit(b)) return false;
+    }
+    return true;
+}
+
+// few distinct keys, and a comparator that only looks at part of the key
+template <typename Q>
+bool duplicateTest(size_t threads) {
+    std::deque<int> a;
+    Q b;
+    build(a, b, N, 16);
+    sortBy(b, std::greater<int>(), threads);
+    std::sort(a.begin(), a.end(), std::greater<int>());
+    if (!isEqual(a, b)) return false;
+    for (int i = 0; i < N; i++) b[i] = a[i] = (i * 7919) % 1000;
+    auto byTens = [](int x, int y) { return x / 10 < y / 10; };
+    sortBy(b, byTens, threads);
+    std::sort(a.begin(), a.end(), byTens);
+    for (int i = 0; i < N; i++)
+        if (a[i] / 10 != b[i] / 10) return false;
+    // the same elements are all still there
+    std::sort(a.begin(), a.end());
+    sjtu::sort(b);
+    return isEqual(a, b);
+}
+
+// already sorted and reverse sorted input
+template <typename Q>
+bool orderedTest(size_t threads) {
+    Q b, c;
+    std::deque<int> a;
+    for (int i = 0; i < N; i++) {
+        a.push_back(i);
+        b.push_back(i);
+        c.push_front(i);
+    }
+    sortBy(b, std::less<int>(), threads);
+    sortBy(c, std::less<int>(), threads);
+    return isEqual(a, b) && isEqual(a, c) && chunksFit(b) && chunksFit(c);
+}
+
+// a deque sharing its chunks with a snapshot: the snapshot is untouched
+// by the sort, and writes after it don't reach the snapshot either
+template <typename Q>
+bool snapshotTest(size_t threads) {
+    std::deque<int> a;
+    Q b;
+    build(a, b, N, 1000);
+    Q s = b.snapshot();
+    sortBy(b, std::less<int>(), threads);
+    std::deque<int> sorted(a);
+    std::sort(sorted.begin(), sorted.end());
+    if (!isEqual(a, s) || !isEqual(sorted, b)) return false;
+    b[0] = -1;
+    b.push_front(-2);
+    return isEqual(a, s) && b[1] == -1;
+}
+
+// more threads than chunks, and thread counts that don't divide them
+template <typename Q>
+bool threadTest() {
+    for (size_t threads : {1, 3, 8, 64})
+        if (!randomTest<Q>(threads) || !snapshotTest<Q>(threads))
+            return false;
+    return true;
+}
+
+bool randomListTest() { return randomTest<ListDeque>(0) && randomTest<ListDeque>(4); }
+bool randomArrayTest() { return randomTest<ArrayDeque>(0) && randomTest<ArrayDeque>(4); }
+bool duplicateListTest() { return duplicateTest<ListDeque>(0) && duplicateTest<ListDeque>(3); }
+bool duplicateArrayTest() { return duplicateTest<ArrayDeque>(0) && duplicateTest<ArrayDeque>(3); }
+bool orderedListTest() { return orderedTest<ListDeque>(0) && orderedTest<ListDeque>(2); }
+bool orderedArrayTest() { return orderedTest<ArrayDeque>(0) && orderedTest<ArrayDeque>(2); }
+bool snapshotListTest() { return snapshotTest<ListDeque>(0) && snapshotTest<ListDeque>(4); }
+bool snapshotArrayTest() { return snapshotTest<ArrayDeque>(0) && snapshotTest<ArrayDeque>(4); }
+bool threadCountTest() { return threadTest<ListDeque>() && threadTest<ArrayDeque>(); }
+
+int main() {
+    bool (*testFunc[])() = {
+        randomListTest, randomArrayTest, duplicateListTest, duplicateArrayTest,
+        orderedListTest, orderedArrayTest, snapshotListTest, snapshotArrayTest,
+        threadCountTest,
+    };
+    const char *testMessage[] = {
+        "Testing random keys (list)...", "Testing random keys (array)...", "Testing duplicate keys (list)...", "Testing duplicate keys (array)...",
+        "Testing sorted / reversed input (list)...", "Testing sorted / reversed input (array)...", "Testing sort with a snapshot (list)...", "Testing sort with a snapshot (array)...",
+        "Testing other thread counts...",
+    };
+
+    bool error = false;
+    for (int i = 0; i < (int)(sizeof(testFunc) / sizeof(testFunc[0])); i++) {
+        printf("%-45s", testMessage[i]);
+        if (testFunc[i]())
+            printf("Passed\n");
+        else {
+            error = true;
+            printf("Failed !!!\n");
+        }
+    }
+
+    if (error)
+        printf("\nUnfortunately, you failed in this test\n\a");
+    else
+        printf("\nCongratulations, your deque passed all the tests!\n");
+
+    return 0;
+}
@@ -0,0 +1,131 @@
+// simd find/count/equal/min/max against the plain loops, and operator==
+
+#include <iostream>
+#include <cstdint>
+#include <cmath>
+
+#include "deque.hpp"
+
+// the vector kernels must agree with the plain loops at every length and
+// alignment, with the match in the vector part, the tail or nowhere
+template <typename T>
+bool kernelTest() {
+    T buf[80], other[80];
+    unsigned seed = 998244353;
+    for (int round = 0; round < 40; round++) {
+        for (int i = 0; i < 80; i++) {
+            seed = seed * 1103515245 + 12345;
+            buf[i] = T((seed >> 10) % 23) - T(round % 2 ? 0 : 5);
+            other[i] = buf[i];
+        }
+        for (size_t off = 0; off < 4; off++)
+            for (size_t n = 0; off + n <= 80; n++) {
+                const T *b = buf + off, *e = b + n;
+                for (int k = 0; k < 23; k += 3) {
+                    T v = T(k) - T(5);
+                    if (sjtu::simd::find(b, e, v) != sjtu::simd::find(b, e, v, std::false_type())) return false;
+                    if (sjtu::simd::count(b, e, v) != sjtu::simd::count(b, e, v, std::false_type())) return false;
+                }
+                if (!sjtu::simd::equal(b, other + off, n)) return false;
+                if (n > 0) {
+                    if (sjtu::simd::min(b, e) != sjtu::simd::min(b, e, std::false_type())) return false;
+                    if (sjtu::simd::max(b, e) != sjtu::simd::max(b, e, std::false_type())) return false;
+                    // one difference anywhere is seen
+                    size_t d = (round * 7) % n;
+                    other[off + d] = T(other[off + d] + 1);
+                    bool same = sjtu::simd::equal(b, other + off, n);
+                    other[off + d] = buf[off + d];
+                    if (same) return false;
+                }
+            }
+    }
+    return true;
+}
+
+bool integerKernelTest() {
+    return kernelTest<int8_t>() && kernelTest<uint8_t>() && kernelTest<int16_t>() && kernelTest<uint16_t>()
+        && kernelTest<int32_t>() && kernelTest<uint32_t>() && kernelTest<int64_t>() && kernelTest<uint64_t>();
+}
+bool floatKernelTest() { return kernelTest<float>() && kernelTest<double>(); }
+
+// NaN is never equal, -0.0 equals 0.0
+bool floatEdgeTest() {
+    double a[40], b[40];
+    for (int i = 0; i < 40; i++) a[i] = b[i] = i;
+    a[33] = b[33] = NAN;
+    if (sjtu::simd::equal(a, b, 40) || !sjtu::simd::equal(a, b, 33)) return false;
+    if (sjtu::simd::find(a, a + 40, double(NAN)) != a + 40) return false;
+    a[5] = -0.0;
+    b[5] = 0.0;
+    return sjtu::simd::equal(a, b, 20) && sjtu::simd::find(a, a + 40, 0.0) == a
+        && sjtu::simd::count(a, a + 40, 0.0) == 2;
+}
+
+// chunks of different lengths and different chunk types compare by
+// their elements only
+template <typename A, typename B>
+bool equalTest() {
+    A a;
+    B b;
+    for (int i = 0; i < 5000; i++) {
+        a.push_back(i % 101);
+        b.push_front((4999 - i) % 101);
+    }
+    b.insert(b.begin() + 2500, 77);
+    b.erase(b.begin() + 2500);
+    if (!(a == b) || a != b) return false;
+    for (int pos : {0, 1, 15, 16, 17, 31, 32, 33, 2499, 4999}) {
+        b[pos] += 1;
+        if (a == b) return false;
+        b[pos] -= 1;
+    }
+    b.pop_back();
+    if (a == b) return false;
+    a.pop_back();
+    A c, d;
+    return a == b && c == d && !(a == c);
+}
+
+typedef sjtu::deque<int> ListDeque;
+typedef sjtu::deque<int, sjtu::circular_array<int>> ArrayDeque;
+
+bool equalListTest() { return equalTest<ListDeque, ListDeque>(); }
+bool equalArrayTest() { return equalTest<ArrayDeque, ArrayDeque>(); }
+bool equalDoubleTest() {
+    typedef sjtu::deque<double, sjtu::circular_array<double>> Q;
+    Q a, b;
+    for (int i = 0; i < 100; i++) {
+        a.push_back(i);
+        b.push_back(i);
+    }
+    a[50] = b[50] = NAN;
+    return !(a == b) && a != b;
+}
+
+int main() {
+    bool (*testFunc[])() = {
+        integerKernelTest, floatKernelTest, floatEdgeTest, equalListTest, equalArrayTest, equalDoubleTest,
+    };
+    const char *testMessage[] = {
+        "Testing integer kernels...", "Testing floating point kernels...", "Testing NaN and -0.0...", "Testing operator== (list)...",
+        "Testing operator== (array)...", "Testing operator== with NaN...",
+    };
+
+    bool error = false;
+    for (int i = 0; i < (int)(sizeof(testFunc) / sizeof(testFunc[0])); i++) {
+        printf("%-45s", testMessage[i]);
+        if (testFunc[i]())
+            printf("Passed\n");
+        else {
+            error = true;
+            printf("Failed !!!\n");
+        }
+    }
+
+    if (error)
+        printf("\nUnfortunately, you failed in this test\n\a");
+    else
+        printf("\nCongratulations, your deque passed all the tests!\n");
+
+    return 0;
+}
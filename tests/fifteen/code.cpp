@@ -0,0 +1,226 @@
+// small deques: one chunk up to Policy::small elements. with local_policy
+// (circular_array chunks) that chunk is kept inside the deque object, so
+// nothing is allocated until it grows past local_n
+
+#include <iostream>
+#include <deque>
+#include <cstdlib>
+#include <new>
+
+#include "deque.hpp"
+
+// every allocation of the program is counted here
+static long allocations = 0;
+
+void *operator new(std::size_t n) {
+    allocations++;
+    if (void *p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void *operator new(std::size_t n, std::align_val_t a) {
+    allocations++;
+    std::size_t al = (std::size_t)a;
+    if (void *p = std::aligned_alloc(al, (n + al - 1) / al * al)) return p;
+    throw std::bad_alloc();
+}
+void *operator new[](std::size_t n) { return operator new(n); }
+void *operator new[](std::size_t n, std::align_val_t a) { return operator new(n, a); }
+// not inlined, or gcc takes the free for one of memory from operator new
+__attribute__((noinline)) void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { operator delete(p); }
+void operator delete(void *p, std::align_val_t) noexcept { operator delete(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { operator delete(p); }
+void operator delete[](void *p) noexcept { operator delete(p); }
+void operator delete[](void *p, std::size_t) noexcept { operator delete(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { operator delete(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { operator delete(p); }
+
+typedef sjtu::deque<int> ListDeque;
+typedef sjtu::deque<int, sjtu::circular_array<int>> ArrayDeque;
+typedef sjtu::deque<int, sjtu::circular_array<int>, sjtu::local_policy<>> LocalDeque;
+
+template <typename Ans, typename Test>
+bool isEqual(Ans &ans, Test &test) {
+    if (ans.size() != test.size())
+        return false;
+    for (int i = 0; i < (int)ans.size(); i++)
+        if (ans[i] != test[i]) return false;
+    return true;
+}
+
+// only local_policy puts elements into the object: one cache line of them
+bool sizeTest() {
+    return ListDeque::local_n == 0 && ArrayDeque::local_n == 0 && sjtu::deque<int, sjtu::double_list<int>, sjtu::local_policy<>>::local_n == 0 &&
+        sizeof(ListDeque) == sizeof(ArrayDeque) && LocalDeque::local_n == 16 && sjtu::deque<double, sjtu::circular_array<double>, sjtu::local_policy<>>::local_n == 8;
+}
+
+// empty deques, moved and swapped ones included, have no pool, chunk
+// or chunk map yet
+template <typename Q>
+bool emptyTest() {
+    Q a, b;
+    a.swap(b);
+    Q c(std::move(a));
+    b = std::move(c);
+    b.clear();
+    for (Q *q : {&a, &b, &c})
+        if (q->pool != nullptr || q->index.map != nullptr || q->spare != nullptr || q->local.used() != nullptr || q->begin() != q->end()) return false;
+    return true;
+}
+
+// pushes at both ends and through the middle stay in one chunk
+template <typename Q>
+bool oneChunkTest() {
+    Q b;
+    std::deque<int> a;
+    for (int i = 0; i < 16; i++) {
+        if (i % 3 == 0) { b.push_front(i); a.push_front(i); }
+        else if (i % 3 == 1) { b.push_back(i); a.push_back(i); }
+        else { b.insert(b.begin() + i / 2, i); a.insert(a.begin() + i / 2, i); }
+        if (b.index.count() != 1) return false;
+    }
+    b.push_back(16);
+    a.push_back(16);
+    for (int i = 0; i < 10; i++) {
+        b.pop_front();
+        a.pop_front();
+    }
+    return isEqual(a, b);
+}
+
+// small deques moved around keep their elements
+template <typename Q>
+bool moveTest() {
+    Q a, b;
+    for (int i = 0; i < 10; i++) {
+        a.push_back(i);
+        b.push_front(i);
+    }
+    a.swap(b);
+    if (a.front() != 9 || b.front() != 0) return false;
+    Q c = a.split_at(5);
+    if (a.size() != 5 || c.size() != 5 || c.front() != 4 || c.back() != 0) return false;
+    b.append(std::move(c));
+    b.prepend(std::move(a));
+    Q s = b.snapshot();
+    b[0] = -1;
+    std::deque<int> expect;
+    for (int i = 9; i >= 5; i--) expect.push_back(i);
+    for (int i = 0; i < 10; i++) expect.push_back(i);
+    for (int i = 4; i >= 0; i--) expect.push_back(i);
+    if (!isEqual(expect, s) || b[0] != -1 || !c.empty() || !a.empty()) return false;
+    expect[0] = -1;
+    return isEqual(expect, b);
+}
+
+// 16 ints pushed at both ends and through the middle, popped, copied,
+// split and snapshotted: not a single allocation
+bool allocTest() {
+    long before = allocations;
+    {
+        LocalDeque b;
+        for (int i = 0; i < 16; i++) {
+            if (i % 3 == 0) b.push_front(i);
+            else if (i % 3 == 1) b.push_back(i);
+            else b.insert(b.begin() + i / 2, i);
+        }
+        b.pop_back();
+        b.pop_front();
+        b.push_back(16);
+        LocalDeque c(b), e;
+        e = c;
+        LocalDeque f = e.split_at(7);
+        LocalDeque s = f.snapshot();
+        f[0] = -1;
+        if (b.size() != 15 || c.size() != 15 || e.size() != 7 || f.size() != 8 || s[0] == -1 || e.index.count() != 1)
+            return false;
+    }
+    return allocations == before;
+}
+
+// swap and move only swap pointers: the local block moves its elements to
+// the heap first, after that no element moves
+bool swapTest() {
+    LocalDeque a, b;
+    for (int i = 0; i < 10; i++) {
+        a.push_back(i);
+        b.push_back(-i);
+    }
+    a.swap(b);
+    if (a.local.used() || b.local.used() || a[3] != -3 || b[3] != 3) return false;
+    int *x = &a[3], *y = &b[3];
+    a.swap(b);
+    LocalDeque c(std::move(a));
+    return &c[3] == y && &b[3] == x && a.empty() && c.size() == 10;
+}
+
+// past local_n the elements go to the heap, after a clear the next small
+// deque is inside the object again
+bool growTest() {
+    LocalDeque b;
+    std::deque<int> a;
+    long before = allocations;
+    for (int i = 0; i < 100; i++) {
+        if (i % 2) { b.push_front(i); a.push_front(i); }
+        else { b.push_back(i); a.push_back(i); }
+    }
+    if (allocations == before || !isEqual(a, b)) return false;
+    b.clear();
+    before = allocations;
+    for (int i = 0; i < 16; i++) b.push_back(i);
+    return allocations == before && b.back() == 15;
+}
+
+// emptied by pops again and again, it goes back to the block inside the
+// object and keeps no spare chunk
+bool reuseTest() {
+    LocalDeque b;
+    long before = allocations;
+    for (int round = 0; round < 5; round++) {
+        for (int i = 0; i < 16; i++) b.push_back(i);
+        for (int i = 0; i < 16; i++) b.pop_front();
+    }
+    return b.empty() && b.index.count() == 0 && b.spare_n == 0 && allocations == before;
+}
+
+bool emptyListTest() { return emptyTest<ListDeque>(); }
+bool emptyArrayTest() { return emptyTest<ArrayDeque>(); }
+bool emptyLocalTest() { return emptyTest<LocalDeque>(); }
+bool oneChunkListTest() { return oneChunkTest<ListDeque>(); }
+bool oneChunkArrayTest() { return oneChunkTest<ArrayDeque>(); }
+bool oneChunkLocalTest() { return oneChunkTest<LocalDeque>(); }
+bool moveListTest() { return moveTest<ListDeque>(); }
+bool moveArrayTest() { return moveTest<ArrayDeque>(); }
+bool moveLocalTest() { return moveTest<LocalDeque>(); }
+
+int main() {
+    bool (*testFunc[])() = {
+        sizeTest, emptyListTest, emptyArrayTest, emptyLocalTest,
+        oneChunkListTest, oneChunkArrayTest, oneChunkLocalTest, moveListTest, moveArrayTest, moveLocalTest,
+        allocTest, swapTest, growTest, reuseTest,
+    };
+    const char *testMessage[] = {
+        "Testing object sizes...", "Testing empty deques (list)...", "Testing empty deques (array)...", "Testing empty deques (local)...",
+        "Testing one chunk (list)...", "Testing one chunk (array)...", "Testing one chunk (local)...",
+        "Testing small moves (list)...", "Testing small moves (array)...", "Testing small moves (local)...",
+        "Testing no allocation (local)...", "Testing swap moves no element (local)...", "Testing growing past the object (local)...", "Testing chunk reuse (local)...",
+    };
+
+    bool error = false;
+    for (int i = 0; i < (int)(sizeof(testFunc) / sizeof(testFunc[0])); i++) {
+        printf("%-45s", testMessage[i]);
+        if (testFunc[i]())
+            printf("Passed\n");
+        else {
+            error = true;
+            printf("Failed !!!\n");
+        }
+    }
+
+    if (error)
+        printf("\nUnfortunately, you failed in this test\n\a");
+    else
+        printf("\nCongratulations, your deque passed all the tests!\n");
+
+    return 0;
+}
@@ -0,0 +1,223 @@
+// move semantics, emplace, bulk insert and erase
+
+#include <iostream>
+#include <deque>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iterator>
+
+#include "deque.hpp"
+
+static const int N = 20000;
+
+class Counted {
+public:
+    static int copies;
+    int *data;
+    int tag;
+    Counted(int a, int b) : data(new int(a)), tag(b) {}
+    Counted(const Counted &other) : data(new int(*other.data)), tag(other.tag) { copies++; }
+    Counted(Counted &&other) : data(other.data), tag(other.tag) { other.data = nullptr; }
+    Counted &operator=(const Counted &other) {
+        if (this == &other) return *this;
+        delete data;
+        data = new int(*other.data);
+        tag = other.tag;
+        copies++;
+        return *this;
+    }
+    Counted &operator=(Counted &&other) {
+        if (this == &other) return *this;
+        delete data;
+        data = other.data;
+        tag = other.tag;
+        other.data = nullptr;
+        return *this;
+    }
+    ~Counted() { delete data; }
+    bool operator==(const Counted &rhs) const { return *data == *rhs.data && tag == rhs.tag; }
+    bool operator!=(const Counted &rhs) const { return !(*this == rhs); }
+};
+int Counted::copies = 0;
+
+template <typename Ans, typename Test>
+bool isEqual(Ans &ans, Test &test) {
+    if (ans.size() != test.size())
+        return false;
+    for (int i = 0; i < (int)ans.size(); i++)
+        if (ans[i] != test[i]) return false;
+    return true;
+}
+
+bool emplaceTest() {
+    std::deque<Counted> a;
+    sjtu::deque<Counted> b;
+    for (int i = 0; i < N; i++) {
+        if (i % 3 == 0) {
+            a.emplace_back(i, 1);
+            b.emplace_back(i, 1);
+        } else if (i % 3 == 1) {
+            a.emplace_front(i, 2);
+            b.emplace_front(i, 2);
+        } else {
+            int pos = (i * 131) % (a.size() + 1);
+            a.emplace(a.begin() + pos, i, 3);
+            b.emplace(b.begin() + pos, i, 3);
+        }
+    }
+    return isEqual(a, b) && b.emplace_back(-1, 4).tag == 4 && b.emplace_front(-2, 5).tag == 5;
+}
+
+bool rvalueTest() {
+    std::deque<std::string> a;
+    sjtu::deque<std::string> b;
+    for (int i = 0; i < N; i++) {
+        std::string s(i % 50 + 20, 'a' + i % 26), t = s;
+        if (i % 3 == 0) {
+            a.push_back(t);
+            b.push_back(std::move(s));
+        } else if (i % 3 == 1) {
+            a.push_front(t);
+            b.push_front(std::move(s));
+        } else {
+            int pos = (i * 17) % (a.size() + 1);
+            a.insert(a.begin() + pos, t);
+            b.insert(b.begin() + pos, std::move(s));
+        }
+        if (!s.empty()) return false;
+    }
+    return isEqual(a, b);
+}
+
+bool moveTest() {
+    sjtu::deque<Counted> b;
+    for (int i = 0; i < N; i++)
+        b.emplace_back(i, 0);
+    int copies = Counted::copies;
+    sjtu::deque<Counted> c(std::move(b));
+    sjtu::deque<Counted> d;
+    d.emplace_back(0, 0);
+    d = std::move(c);
+    c.swap(d);
+    if (Counted::copies != copies) return false;
+    if (!b.empty() || !d.empty() || c.size() != N) return false;
+    for (int i = 0; i < N; i++)
+        if (*c[i].data != i) return false;
+    b.emplace_back(1, 1);
+    return b.size() == 1;
+}
+
+bool bulkTest() {
+    std::vector<int> v;
+    for (int i = 0; i < N; i++)
+        v.push_back(i * 7 % 1000);
+    std::deque<int> a(v.begin(), v.end());
+    sjtu::deque<int> b(v.begin(), v.end());
+    if (!isEqual(a, b)) return false;
+    sjtu::deque<int> c(b.begin(), b.end()), d(N, 5);
+    if (!isEqual(a, c) || d.size() != N || d[N / 2] != 5) return false;
+    for (int i = 0; i < 50; i++) {
+        int pos = (i * 997) % (a.size() + 1), len = i * 13 % 200;
+        if (i % 2) {
+            a.insert(a.begin() + pos, len, i);
+            auto it = b.insert(b.begin() + pos, len, i);
+            if (it - b.begin() != pos) return false;
+        } else {
+            a.insert(a.begin() + pos, v.begin(), v.begin() + len);
+            auto it = b.insert(b.begin() + pos, v.begin(), v.begin() + len);
+            if (it - b.begin() != pos) return false;
+        }
+    }
+    if (!isEqual(a, b)) return false;
+    std::istringstream in("3 1 4 1 5 9 2 6");
+    b.insert(b.begin() + 3, std::istream_iterator<int>(in), std::istream_iterator<int>());
+    a.insert(a.begin() + 3, {3, 1, 4, 1, 5, 9, 2, 6});
+    if (!isEqual(a, b)) return false;
+    a.assign(100, 1);
+    b.assign(100, 1);
+    c.assign(v.begin(), v.begin() + 10);
+    return isEqual(a, b) && c.size() == 10 && c[9] == v[9];
+}
+
+bool rangeEraseTest() {
+    std::deque<int> a;
+    sjtu::deque<int> b;
+    for (int i = 0; i < N * 20; i++) {
+        a.push_back(i);
+        b.push_back(i);
+    }
+    for (int i = 0; i < 100; i++) {
+        int l = (i * 7919) % (a.size() + 1), r = l + (i * 31 % 3000);
+        if (r > (int)a.size()) r = a.size();
+        a.erase(a.begin() + l, a.begin() + r);
+        auto it = b.erase(b.begin() + l, b.begin() + r);
+        if (it - b.begin() != l) return false;
+        a.erase(a.begin(), a.begin() + i * 3);
+        b.pop_front(i * 3);
+        a.erase(a.end() - i, a.end());
+        b.pop_back(i);
+    }
+    if (!isEqual(a, b)) return false;
+    b.pop_front(b.size() / 2);
+    b.pop_back(b.size());
+    return b.empty() && b.erase(b.begin(), b.end()) == b.end();
+}
+
+bool spliceTest() {
+    std::deque<int> a;
+    sjtu::deque<int> b;
+    for (int i = 0; i < N * 5; i++) {
+        a.push_back(i);
+        b.push_back(i);
+    }
+    for (int i = 0; i < 50; i++) {
+        int p = (i * 7919) % (a.size() + 1);
+        sjtu::deque<int> c = b.split_at(p);
+        if ((int)b.size() != p || c.size() != a.size() - p) return false;
+        if (i % 2 == 0) b.append(std::move(c));
+        else {
+            c.prepend(std::move(b));
+            b = std::move(c);
+        }
+        if (!c.empty()) return false;
+        sjtu::deque<int> d;
+        for (int j = 0; j < i; j++) d.push_back(j);
+        if (i % 3 == 0) {
+            b.prepend(std::move(d));
+            for (int j = i - 1; j >= 0; j--) a.push_front(j);
+        } else {
+            b.append(std::move(d));
+            for (int j = 0; j < i; j++) a.push_back(j);
+        }
+    }
+    return isEqual(a, b);
+}
+int main() {
+    bool (*testFunc[])() = {
+        emplaceTest, rvalueTest, moveTest, bulkTest,
+        rangeEraseTest, spliceTest,
+    };
+    const char *testMessage[] = {
+        "Testing emplace...", "Testing rvalue push and insert...", "Testing move and swap...", "Testing bulk insert...",
+        "Testing range erase...", "Testing append and split...",
+    };
+
+    bool error = false;
+    for (int i = 0; i < (int)(sizeof(testFunc) / sizeof(testFunc[0])); i++) {
+        printf("%-40s", testMessage[i]);
+        if (testFunc[i]())
+            printf("Passed\n");
+        else {
+            error = true;
+            printf("Failed !!!\n");
+        }
+    }
+
+    if (error)
+        printf("\nUnfortunately, you failed in this test\n\a");
+    else
+        printf("\nCongratulations, your deque passed all the tests!\n");
+
+    return 0;
+}
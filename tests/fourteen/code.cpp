@@ -0,0 +1,132 @@
+// ring_deque: fixed capacity inside the object, with and without overwrite
+
+#include <iostream>
+#include <deque>
+#include <string>
+
+#include "deque.hpp"
+
+template <typename Ans, typename Test>
+bool isEqual(Ans &ans, Test &test) {
+    if (ans.size() != test.size())
+        return false;
+    for (int i = 0; i < (int)ans.size(); i++)
+        if (ans[i] != test[i]) return false;
+    return true;
+}
+
+// the same as std::deque while it isn't full, with a capacity that isn't
+// a power of two and pushes at both ends wrapping the slots around
+bool randomTest() {
+    sjtu::ring_deque<int, 37> q;
+    std::deque<int> a;
+    unsigned seed = 7;
+    for (int i = 0; i < 100000; i++) {
+        seed = seed * 1103515245 + 12345;
+        int x = seed >> 8;
+        switch (x % 4) {
+        case 0: if (!q.full()) { q.push_back(x); a.push_back(x); } break;
+        case 1: if (!q.full()) { q.push_front(x); a.push_front(x); } break;
+        case 2: if (!a.empty()) { q.pop_back(); a.pop_back(); } break;
+        default: if (!a.empty()) { q.pop_front(); a.pop_front(); }
+        }
+        if (!isEqual(a, q) || q.full() != (a.size() == 37)) return false;
+    }
+    return true;
+}
+
+bool fullTest() {
+    sjtu::ring_deque<int, 4> q;
+    for (int i = 0; i < 4; i++) q.push_back(i);
+    int thrown = 0;
+    try { q.push_back(4); } catch (sjtu::runtime_error &) { thrown++; }
+    try { q.push_front(4); } catch (sjtu::runtime_error &) { thrown++; }
+    try { q.at(4); } catch (sjtu::index_out_of_bound &) { thrown++; }
+    for (int i = 0; i < 4; i++) q.pop_front();
+    try { q.pop_front(); } catch (sjtu::container_is_empty &) { thrown++; }
+    try { q.front(); } catch (sjtu::container_is_empty &) { thrown++; }
+    return thrown == 5 && q.empty();
+}
+
+// overwrite drops the other end, the newest capacity() elements are kept
+bool overwriteTest() {
+    sjtu::ring_deque<int, 5, true> q;
+    for (int i = 0; i < 23; i++) q.push_back(i);
+    if (q.size() != 5 || q.front() != 18 || q.back() != 22) return false;
+    q.push_front(100);
+    return q.size() == 5 && q.front() == 100 && q.back() == 21 && q[1] == 18;
+}
+
+// a throwing constructor loses nothing, even when full with overwrite
+bool exceptionTest() {
+    struct Boom {
+        int v;
+        Boom(int v_) : v(v_) { if (v_ < 0) throw v_; }
+    };
+    sjtu::ring_deque<Boom, 3, true> q;
+    for (int i = 0; i < 3; i++) q.emplace_back(i);
+    try { q.emplace_back(-1); } catch (int) {}
+    try { q.emplace_front(-1); } catch (int) {}
+    return q.size() == 3 && q[0].v == 0 && q[2].v == 2;
+}
+
+// iterators hold a position, not a slot: pushes and pops at the ends
+// leave the others valid
+bool iteratorTest() {
+    sjtu::ring_deque<int, 10> q;
+    for (int i = 0; i < 6; i++) q.push_back(i);
+    auto it = q.begin() + 3;
+    q.pop_front();
+    q.push_front(-1);
+    q.push_front(-2);
+    q.pop_back();
+    if (*it != 3 || it - q.begin() != 4) return false;
+    int sum = 0;
+    for (auto x : q) sum += x;
+    const auto &c = q;
+    auto cit = c.cbegin();
+    cit += 2;
+    bool thrown = false;
+    try { q.end() + 1; } catch (sjtu::index_out_of_bound &) { thrown = true; }
+    return sum == 7 && *cit == 1 && cit < c.cend() && thrown && q.end() - q.begin() == 6;
+}
+
+// copies, and destructors for the elements left
+bool copyTest() {
+    sjtu::ring_deque<std::string, 8, true> q;
+    for (int i = 0; i < 20; i++) q.push_front(std::string(i, 'a'));
+    sjtu::ring_deque<std::string, 8, true> r(q), s;
+    s = q;
+    q.pop_back();
+    q.push_back("x");
+    return r.size() == 8 && r[0] == std::string(19, 'a') && r[7] == std::string(12, 'a') && s.back() == r.back()
+        && q.back() == "x";
+}
+
+int main() {
+    bool (*testFunc[])() = {
+        randomTest, fullTest, overwriteTest, exceptionTest, iteratorTest, copyTest,
+    };
+    const char *testMessage[] = {
+        "Testing random operations...", "Testing a full ring...", "Testing overwrite...", "Testing throwing constructors...",
+        "Testing iterators...", "Testing copies...",
+    };
+
+    bool error = false;
+    for (int i = 0; i < (int)(sizeof(testFunc) / sizeof(testFunc[0])); i++) {
+        printf("%-45s", testMessage[i]);
+        if (testFunc[i]())
+            printf("Passed\n");
+        else {
+            error = true;
+            printf("Failed !!!\n");
+        }
+    }
+
+    if (error)
+        printf("\nUnfortunately, you failed in this test\n\a");
+    else
+        printf("\nCongratulations, your deque passed all the tests!\n");
+
+    return 0;
+}
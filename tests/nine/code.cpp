@@ -0,0 +1,147 @@
+// segmented iteration and the segment-wise algorithms, for both chunk types
+
+#include <iostream>
+#include <deque>
+#include <algorithm>
+#include <numeric>
+
+#include "deque.hpp"
+
+static const int N = 20000;
+
+typedef sjtu::deque<int> ListDeque;
+typedef sjtu::deque<int, sjtu::circular_array<int>> ArrayDeque;
+
+// pushed at both ends and through the middle, so the chunks have all
+// kinds of lengths (and the arrays wrap around)
+template <typename Q>
+void build(std::deque<int> &a, Q &b) {
+    unsigned seed = 19260817;
+    for (int i = 0; i < N; i++) {
+        seed = seed * 1103515245 + 12345;
+        int x = (seed >> 8) % 1000;
+        if (i % 3 == 0) { a.push_front(x); b.push_front(x); }
+        else if (i % 3 == 1) { a.push_back(x); b.push_back(x); }
+        else { a.insert(a.begin() + x % a.size(), x); b.insert(b.begin() + x % b.size(), x); }
+    }
+}
+
+template <typename Q>
+bool forEachSegmentTest() {
+    std::deque<int> a;
+    Q b;
+    build(a, b);
+    std::deque<int> seen;
+    size_t segs = 0;
+    b.for_each_segment([&](auto first, auto last) {
+        segs++;
+        for (; first != last; ++first) seen.push_back(*first);
+    });
+    // writes through a segment land in the deque
+    b.for_each_segment([](auto first, auto last) {
+        for (; first != last; ++first) *first += 1;
+    });
+    for (auto &x : a) x += 1;
+    const Q &c = b;
+    long sum = 0;
+    c.for_each_segment([&](auto first, auto last) {
+        for (; first != last; ++first) sum += *first;
+    });
+    for (size_t i = 0; i < a.size(); i++)
+        if (a[i] != b[i] || a[i] != seen[i] + 1) return false;
+    return seen.size() == a.size() && segs >= b.index.count()
+        && sum == std::accumulate(a.begin(), a.end(), 0L);
+}
+
+template <typename Q>
+bool algorithmTest() {
+    std::deque<int> a;
+    Q b;
+    build(a, b);
+    for (int k = 0; k < 200; k++) {
+        int l = (k * 7919) % N, r = l + (k * 104729) % (N - l + 1);
+        auto first = b.begin() + l, last = b.begin() + r;
+        auto af = a.begin() + l, al = a.begin() + r;
+        int v = k * 5;
+        if ((sjtu::find(first, last, v) - b.begin()) != (std::find(af, al, v) - a.begin())) return false;
+        if (sjtu::count(first, last, v) != (size_t)std::count(af, al, v)) return false;
+        if ((sjtu::min_element(first, last) - b.begin()) != (std::min_element(af, al) - a.begin())) return false;
+        if ((sjtu::max_element(first, last) - b.begin()) != (std::max_element(af, al) - a.begin())) return false;
+        if (sjtu::accumulate(first, last, 0L) != std::accumulate(af, al, 0L)) return false;
+        long prod = sjtu::accumulate(first, last, 0L, [](long s, int x) { return (s * 31 + x) % 1000003; });
+        if (prod != std::accumulate(af, al, 0L, [](long s, int x) { return (s * 31 + x) % 1000003; })) return false;
+    }
+    std::deque<int> out(N);
+    sjtu::copy(b.cbegin(), b.cend(), out.begin());
+    long cnt = 0;
+    sjtu::for_each(b.begin(), b.end(), [&](int &x) { cnt += x; x = -x; });
+    for (int i = 0; i < N; i++)
+        if (out[i] != a[i] || b[i] != -a[i]) return false;
+    return cnt == std::accumulate(a.begin(), a.end(), 0L);
+}
+
+// empty ranges and a deque of one element
+template <typename Q>
+bool edgeTest() {
+    Q b;
+    if (sjtu::find(b.begin(), b.end(), 1) != b.end()) return false;
+    if (sjtu::min_element(b.begin(), b.end()) != b.end()) return false;
+    if (sjtu::count(b.begin(), b.end(), 1) != 0) return false;
+    b.push_back(1);
+    if (sjtu::find(b.begin(), b.end(), 1) != b.begin()) return false;
+    if (sjtu::max_element(b.begin(), b.end()) != b.begin()) return false;
+    return sjtu::find(b.begin() + 1, b.end(), 1) == b.end();
+}
+
+// segments over chunks shared with a snapshot: writes must not reach it
+template <typename Q>
+bool snapshotTest() {
+    std::deque<int> a;
+    Q b;
+    build(a, b);
+    Q s = b.snapshot();
+    b.for_each_segment([](auto first, auto last) {
+        for (; first != last; ++first) *first = 0;
+    });
+    for (int i = 0; i < N; i++)
+        if (s[i] != a[i] || b[i] != 0) return false;
+    return sjtu::count(s.cbegin(), s.cend(), 0) == (size_t)std::count(a.begin(), a.end(), 0);
+}
+
+bool forEachSegmentListTest() { return forEachSegmentTest<ListDeque>(); }
+bool forEachSegmentArrayTest() { return forEachSegmentTest<ArrayDeque>(); }
+bool algorithmListTest() { return algorithmTest<ListDeque>(); }
+bool algorithmArrayTest() { return algorithmTest<ArrayDeque>(); }
+bool edgeListTest() { return edgeTest<ListDeque>(); }
+bool edgeArrayTest() { return edgeTest<ArrayDeque>(); }
+bool snapshotListTest() { return snapshotTest<ListDeque>(); }
+bool snapshotArrayTest() { return snapshotTest<ArrayDeque>(); }
+
+int main() {
+    bool (*testFunc[])() = {
+        forEachSegmentListTest, forEachSegmentArrayTest, algorithmListTest, algorithmArrayTest,
+        edgeListTest, edgeArrayTest, snapshotListTest, snapshotArrayTest,
+    };
+    const char *testMessage[] = {
+        "Testing for_each_segment (list)...", "Testing for_each_segment (array)...", "Testing segmented algorithms (list)...", "Testing segmented algorithms (array)...",
+        "Testing empty ranges (list)...", "Testing empty ranges (array)...", "Testing segments of a snapshot (list)...", "Testing segments of a snapshot (array)...",
+    };
+
+    bool error = false;
+    for (int i = 0; i < (int)(sizeof(testFunc) / sizeof(testFunc[0])); i++) {
+        printf("%-45s", testMessage[i]);
+        if (testFunc[i]())
+            printf("Passed\n");
+        else {
+            error = true;
+            printf("Failed !!!\n");
+        }
+    }
+
+    if (error)
+        printf("\nUnfortunately, you failed in this test\n\a");
+    else
+        printf("\nCongratulations, your deque passed all the tests!\n");
+
+    return 0;
+}
@@ -0,0 +1,113 @@
+// steal_deque: the owner grows the ring while thieves steal
+
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <vector>
+
+#include "deque.hpp"
+
+static const long N = 100000;
+static const int THIEVES = 4;
+
+static std::atomic<unsigned char> seen[N];
+
+bool sequentialTest() {
+    sjtu::steal_deque<int, 64> q;
+    for (int i = 0; i < 1000; i++) q.push_back(i);
+    int x;
+    for (int i = 0; i < 300; i++)
+        if (!q.steal(x) || x != i) return false;
+    for (int i = 0; i < 2000; i++) q.push_back(1000 + i);
+    for (int i = 2999; i >= 300; i--)
+        if (!q.try_pop_back(x) || x != i) return false;
+    return !q.try_pop_back(x) && !q.steal(x) && q.empty();
+}
+
+// a thief still holding the directory from before a grow must read what
+// was there: cap 2, grow at top 1 / bottom 5, then top moves to 4 and the
+// owner pushes up to 8
+bool staleDirectoryTest() {
+    sjtu::steal_deque<long, 16> q;
+    long x;
+    for (long i = 0; i < 4; i++) q.push_back(i);
+    q.steal(x);
+    q.push_back(4);
+    q.push_back(5);
+    auto *old = q.array.load()->prev;
+    if (!old) return false;
+    for (int i = 0; i < 3; i++) q.steal(x);
+    for (long i = 6; i <= 8; i++) q.push_back(i);
+    return old->at(4).load() == 4 && q.steal(x) && x == 4;
+}
+
+// chunks of two slots: the ring grows often, and with thieves moving top
+// the live range rarely starts on a chunk boundary when it does
+template <size_t Bytes>
+bool growTest(int rounds) {
+    for (int round = 0; round < rounds; round++) {
+        sjtu::steal_deque<long, Bytes> q;
+        for (long i = 0; i < N; i++) seen[i] = 0;
+        std::atomic<bool> done(false);
+        std::atomic<long> got(0);
+        std::vector<std::thread> th;
+        for (int k = 0; k < THIEVES; k++)
+            th.emplace_back([&] {
+                long x;
+                while (!done)
+                    if (q.steal(x)) {
+                        seen[x]++;
+                        got++;
+                    }
+            });
+        long x;
+        for (long i = 0; i < N; i++) {
+            q.push_back(i);
+            if (i % 5 == 0 && q.try_pop_back(x)) {
+                seen[x]++;
+                got++;
+            }
+        }
+        while (q.try_pop_back(x)) {
+            seen[x]++;
+            got++;
+        }
+        while (got < N) std::this_thread::yield();
+        done = true;
+        for (auto &t : th) t.join();
+        for (long i = 0; i < N; i++)
+            if (seen[i] != 1) return false;
+    }
+    return true;
+}
+
+bool smallChunkTest() { return growTest<16>(30); }
+bool pageChunkTest() { return growTest<4096>(10); }
+
+int main() {
+    bool (*testFunc[])() = {
+        sequentialTest, staleDirectoryTest, smallChunkTest, pageChunkTest,
+    };
+    const char *testMessage[] = {
+        "Testing push, pop and steal...", "Testing stale directory after grow...", "Testing steal while growing (2 slots)...", "Testing steal while growing (page)...",
+    };
+
+    bool error = false;
+    for (int i = 0; i < (int)(sizeof(testFunc) / sizeof(testFunc[0])); i++) {
+        printf("%-45s", testMessage[i]);
+        fflush(stdout);
+        if (testFunc[i]())
+            printf("Passed\n");
+        else {
+            error = true;
+            printf("Failed !!!\n");
+        }
+    }
+
+    if (error)
+        printf("\nUnfortunately, you failed in this test\n\a");
+    else
+        printf("\nCongratulations, your deque passed all the tests!\n");
+
+    return 0;
+}
@@ -0,0 +1,143 @@
+// append / prepend / split_at: the chunks move to the receiver's own
+// pool, so the two deques can be used from two threads without locking
+
+#include <iostream>
+#include <deque>
+#include <thread>
+
+#include "deque.hpp"
+
+static const int N = 20000;
+
+typedef sjtu::deque<int, sjtu::double_list<int>> ListDeque;
+typedef sjtu::deque<int, sjtu::circular_array<int>> ArrayDeque;
+
+template <typename Ans, typename Test>
+bool isEqual(Ans &ans, Test &test) {
+    if (ans.size() != test.size())
+        return false;
+    for (int i = 0; i < (int)ans.size(); i++)
+        if (ans[i] != test[i]) return false;
+    return true;
+}
+
+// every chunk takes its nodes from the deque's own pool (circular_array
+// chunks have none)
+bool samePool(ArrayDeque &) { return true; }
+bool samePool(ListDeque &q) {
+    for (size_t i = q.index.lo; i < q.index.hi; i++)
+        if (q.index.map[i]->chunk->pool != q.pool) return false;
+    return true;
+}
+
+template <typename Q>
+bool splitAppendTest() {
+    std::deque<int> a;
+    Q b;
+    for (int i = 0; i < N; i++) { a.push_back(i); b.push_back(i); }
+    for (int round = 0; round < 50; round++) {
+        size_t pos = (round * 7919) % (a.size() + 1);
+        Q c = b.split_at(pos);
+        std::deque<int> d(a.begin() + pos, a.end());
+        a.erase(a.begin() + pos, a.end());
+        if (!isEqual(a, b) || !isEqual(d, c) || !samePool(b) || !samePool(c)) return false;
+        c.push_front(-round);
+        d.push_front(-round);
+        if (round % 2) {
+            b.append(std::move(c));
+            a.insert(a.end(), d.begin(), d.end());
+        } else {
+            c.prepend(std::move(b));
+            b.swap(c);
+            a.insert(a.end(), d.begin(), d.end());
+        }
+        if (!c.empty() || !isEqual(a, b) || !samePool(b)) return false;
+    }
+    return true;
+}
+
+// the pools never start locking, and nodes freed after the move go to
+// the new pool
+bool noLockTest() {
+    ListDeque b, e;
+    for (int i = 0; i < N; i++) b.push_back(i);
+    ListDeque c = b.split_at(N / 2);
+    e.append(std::move(c));
+    e.prepend(std::move(b));
+    if (e.pool->locking || !samePool(e)) return false;
+    size_t live = e.pool->live;
+    for (int i = 0; i < 100; i++) e.pop_back();
+    return e.pool->live + 100 == live && e.size() == N - 100;
+}
+
+// both halves worked on at once from two threads
+template <typename Q>
+bool threadTest() {
+    Q b;
+    for (int i = 0; i < N; i++) b.push_back(i);
+    for (int round = 0; round < 20; round++) {
+        Q c = b.split_at(b.size() / 2 + round);
+        std::thread t([&] {
+            for (int k = 0; k < 2000; k++) {
+                c.push_front(k);
+                c.erase(c.begin() + k % c.size());
+            }
+        });
+        for (int k = 0; k < 2000; k++) {
+            b.push_back(k);
+            b.erase(b.begin() + k % b.size());
+        }
+        t.join();
+        b.append(std::move(c));
+    }
+    return b.size() == N && samePool(b);
+}
+
+// a split of a deque with a snapshot keeps sharing the chunks
+template <typename Q>
+bool snapshotTest() {
+    std::deque<int> a;
+    Q b;
+    for (int i = 0; i < N; i++) { a.push_back(i); b.push_back(i); }
+    Q s = b.snapshot();
+    Q c = b.split_at(N / 3);
+    c[0] = -1;
+    b.append(std::move(c));
+    return isEqual(a, s) && b[N / 3] == -1 && b.size() == N;
+}
+
+bool splitAppendListTest() { return splitAppendTest<ListDeque>(); }
+bool splitAppendArrayTest() { return splitAppendTest<ArrayDeque>(); }
+bool threadListTest() { return threadTest<ListDeque>(); }
+bool threadArrayTest() { return threadTest<ArrayDeque>(); }
+bool snapshotListTest() { return snapshotTest<ListDeque>(); }
+bool snapshotArrayTest() { return snapshotTest<ArrayDeque>(); }
+
+int main() {
+    bool (*testFunc[])() = {
+        splitAppendListTest, splitAppendArrayTest, noLockTest, threadListTest,
+        threadArrayTest, snapshotListTest, snapshotArrayTest,
+    };
+    const char *testMessage[] = {
+        "Testing split_at / append (list)...", "Testing split_at / append (array)...", "Testing pools stay unlocked...", "Testing halves in two threads (list)...",
+        "Testing halves in two threads (array)...", "Testing split with a snapshot (list)...", "Testing split with a snapshot (array)...",
+    };
+
+    bool error = false;
+    for (int i = 0; i < (int)(sizeof(testFunc) / sizeof(testFunc[0])); i++) {
+        printf("%-45s", testMessage[i]);
+        if (testFunc[i]())
+            printf("Passed\n");
+        else {
+            error = true;
+            printf("Failed !!!\n");
+        }
+    }
+
+    if (error)
+        printf("\nUnfortunately, you failed in this test\n\a");
+    else
+        printf("\nCongratulations, your deque passed all the tests!\n");
+
+    return 0;
+}
@@ -0,0 +1,212 @@
+// snapshots: chunks shared until written, for both chunk types
+
+#include <iostream>
+#include <deque>
+#include <algorithm>
+#include <thread>
+
+#include "deque.hpp"
+
+static const int N = 20000;
+
+typedef sjtu::deque<int> ListDeque;
+typedef sjtu::deque<int, sjtu::circular_array<int>> ArrayDeque;
+
+template <typename Ans, typename Test>
+bool isEqual(Ans &ans, Test &test) {
+    if (ans.size() != test.size())
+        return false;
+    for (int i = 0; i < (int)ans.size(); i++)
+        if (ans[i] != test[i]) return false;
+    return true;
+}
+
+template <typename Q>
+size_t sharedChunks(Q &q) {
+    size_t n = 0;
+    for (size_t i = q.index.lo; i < q.index.hi; i++)
+        n += q.index.map[i]->chunk->refs.load() > 1;
+    return n;
+}
+
+template <typename Q>
+bool snapshotTest() {
+    std::deque<int> a;
+    Q b;
+    for (int i = 0; i < N; i++) {
+        a.push_back(i);
+        b.push_back(i);
+    }
+    Q s = b.snapshot();
+    std::deque<int> old = a;
+    for (int i = 0; i < 200; i++) {
+        int pos = (i * 7919) % a.size();
+        switch (i % 5) {
+        case 0: a[pos] = -i; b[pos] = -i; break;
+        case 1: a.insert(a.begin() + pos, i); b.insert(b.begin() + pos, i); break;
+        case 2: a.erase(a.begin() + pos); b.erase(b.begin() + pos); break;
+        case 3: a.push_front(i); b.push_front(i); a.pop_back(); b.pop_back(); break;
+        default: a.push_back(i); b.push_back(i); a.pop_front(); b.pop_front();
+        }
+    }
+    return isEqual(a, b) && isEqual(old, s);
+}
+
+template <typename Q>
+bool beginEndTest() {
+    Q b;
+    for (int i = 0; i < N; i++)
+        b.push_back(i);
+    Q s = b.snapshot();
+    size_t shared = sharedChunks(b);
+    auto first = b.begin(), last = b.end();
+    b.insert(b.end(), -1);
+    if (first == last || shared == 0 || sharedChunks(b) + 1 < shared) return false;
+    const Q &c = b;
+    for (int x : c) (void)x;
+    b.pop_back();
+    std::deque<int> a(s.cbegin(), s.cend());
+    return sharedChunks(b) + 1 >= shared && isEqual(a, b);
+}
+
+template <typename Q>
+bool iteratorWriteTest() {
+    Q b;
+    for (int i = 0; i < N; i++)
+        b.push_back(i);
+    Q s = b.snapshot();
+    auto x = b.begin() + 100, y = b.begin() + 101;
+    typename Q::const_iterator z = b.cbegin() + 102;
+    *x = -1;
+    *y = -2;
+    *(b.begin() + 102) = -3;
+    if (*z != -3 || b[100] != -1 || b[101] != -2) return false;
+    if (s[100] != 100 || s[101] != 101 || s[102] != 102) return false;
+    std::sort(b.begin(), b.end());
+    for (int i = 0; i < N; i++)
+        if (s[i] != i) return false;
+    return b[0] == -3 && b[3] == 0 && b.back() == N - 1;
+}
+
+template <typename Q>
+bool threadTest() {
+    Q b;
+    for (int i = 0; i < N; i++)
+        b.push_back(i);
+    Q s = b.snapshot();
+    bool ok = true;
+    std::thread t([&] {
+        for (int k = 0; k < 20; k++)
+            for (int i = 0; i < N; i += 37)
+                if (s[i] != i) ok = false;
+    });
+    for (int i = 0; i < N; i += 7)
+        b[i] = -i;
+    for (int i = 0; i < 1000; i++)
+        b.push_front(i);
+    t.join();
+    return ok && b[1000 + 7] == -7 && s[7] == 7;
+}
+
+// readers taking snapshots of one deque at the same time, from a deque
+// written meanwhile that shares its chunks, and snapshots of snapshots
+template <typename Q>
+bool concurrentSnapshotTest() {
+    Q d;
+    for (int i = 0; i < N; i++)
+        d.push_back(i);
+    const Q cd = d.snapshot();
+    bool ok[5] = {true, true, true, true, true};
+    std::thread t[5];
+    for (int k = 0; k < 4; k++)
+        t[k] = std::thread([&, k] {
+            for (int r = 0; r < 10; r++) {
+                Q s = cd.snapshot();
+                Q s2 = s.snapshot();
+                for (int i = k; i < N; i += 101)
+                    s2[i] = -i;
+                s.push_front(-1);
+                for (int i = k; i < N; i += 101)
+                    if (s[i + 1] != i || s2[i] != -i) ok[k] = false;
+            }
+        });
+    t[4] = std::thread([&] {
+        for (int i = 0; i < N; i += 3)
+            d[i] = -i;
+        for (int i = 0; i < 1000; i++)
+            d.push_front(i);
+        if (d[1000 + 3] != -3) ok[4] = false;
+    });
+    for (int k = 0; k < 5; k++)
+        t[k].join();
+    for (int i = 0; i < N; i++)
+        if (cd[i] != i) return false;
+    return ok[0] && ok[1] && ok[2] && ok[3] && ok[4];
+}
+
+// list iterators taken before a push_front / insert in their chunk, then
+// written through after a snapshot: they must land on their own element
+// in the clone, even after the snapshot is gone
+bool pushedIteratorTest() {
+    typedef sjtu::deque<int, sjtu::double_list<int>> ListDeque;
+    ListDeque b;
+    for (int i = 0; i < 10; i++)
+        b.push_back(i);
+    auto x = b.begin() + 5, y = b.begin() + 7;
+    b.push_front(-1);
+    b.insert(b.begin() + 2, -2);
+    {
+        ListDeque s = b.snapshot();
+        *x = 100;
+        int want[] = {-1, 0, -2, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+        for (int i = 0; i < 12; i++)
+            if (s[i] != want[i]) return false;
+    }
+    *y = 200;
+    int want[] = {-1, 0, -2, 1, 2, 3, 4, 100, 6, 200, 8, 9};
+    for (int i = 0; i < 12; i++)
+        if (b[i] != want[i]) return false;
+    return *x == 100 && y - x == 2 && x - b.begin() == 7;
+}
+
+bool snapshotListTest() { return snapshotTest<ListDeque>(); }
+bool snapshotArrayTest() { return snapshotTest<ArrayDeque>(); }
+bool beginEndListTest() { return beginEndTest<ListDeque>(); }
+bool beginEndArrayTest() { return beginEndTest<ArrayDeque>(); }
+bool iteratorWriteListTest() { return iteratorWriteTest<ListDeque>(); }
+bool iteratorWriteArrayTest() { return iteratorWriteTest<ArrayDeque>(); }
+bool threadListTest() { return threadTest<ListDeque>(); }
+bool threadArrayTest() { return threadTest<ArrayDeque>(); }
+bool concurrentListTest() { return concurrentSnapshotTest<ListDeque>(); }
+bool concurrentArrayTest() { return concurrentSnapshotTest<ArrayDeque>(); }
+
+int main() {
+    bool (*testFunc[])() = {
+        snapshotListTest, snapshotArrayTest, beginEndListTest, beginEndArrayTest,
+        iteratorWriteListTest, iteratorWriteArrayTest, threadListTest, threadArrayTest,
+        concurrentListTest, concurrentArrayTest, pushedIteratorTest,
+    };
+    const char *testMessage[] = {
+        "Testing snapshot (list)...", "Testing snapshot (array)...", "Testing begin/end copy nothing (list)...", "Testing begin/end copy nothing (array)...",
+        "Testing write through iterators (list)...", "Testing write through iterators (array)...", "Testing snapshot threads (list)...", "Testing snapshot threads (array)...",
+        "Testing concurrent snapshots (list)...", "Testing concurrent snapshots (array)...", "Testing iterators kept over a push (list)...",
+    };
+
+    bool error = false;
+    for (int i = 0; i < (int)(sizeof(testFunc) / sizeof(testFunc[0])); i++) {
+        printf("%-45s", testMessage[i]);
+        if (testFunc[i]())
+            printf("Passed\n");
+        else {
+            error = true;
+            printf("Failed !!!\n");
+        }
+    }
+
+    if (error)
+        printf("\nUnfortunately, you failed in this test\n\a");
+    else
+        printf("\nCongratulations, your deque passed all the tests!\n");
+
+    return 0;
+}
@@ -0,0 +1,148 @@
+// reserve / capacity / shrink_to_fit and the spare chunks, for both chunk
+// types
+
+#include <iostream>
+#include <deque>
+
+#include "deque.hpp"
+
+typedef sjtu::deque<int> ListDeque;
+typedef sjtu::deque<int, sjtu::circular_array<int>> ArrayDeque;
+
+template <typename Ans, typename Test>
+bool isEqual(Ans &ans, Test &test) {
+    if (ans.size() != test.size())
+        return false;
+    for (int i = 0; i < (int)ans.size(); i++)
+        if (ans[i] != test[i]) return false;
+    return true;
+}
+
+// after reserve(n) pushing at both ends up to n makes no chunk map, no
+// slab and no array: the capacity stays the same and every chunk comes
+// from the spare list
+template <typename Q>
+bool reserveTest() {
+    for (int n : {10, 100, 5000, 40000}) {
+        Q b;
+        std::deque<int> a;
+        for (int i = 0; i < n / 10; i++) { b.push_back(i); a.push_back(i); }
+        b.reserve(n);
+        if (b.capacity() < (size_t)n) return false;
+        size_t *map = (size_t *)b.index.map, cap = b.capacity(), spare = b.spare_n;
+        for (int i = n / 10; i < n; i++) {
+            if (i % 2) { b.push_back(i); a.push_back(i); }
+            else { b.push_front(i); a.push_front(i); }
+        }
+        if ((size_t *)b.index.map != map || b.capacity() != cap || !isEqual(a, b)) return false;
+        if (b.spare_n > spare) return false;
+    }
+    return true;
+}
+
+// the chunks emptied by pops after a reserve are all kept (the capacity
+// stays), shrink_to_fit drops them
+template <typename Q>
+bool shrinkTest() {
+    Q b;
+    b.reserve(10000);
+    size_t cap = b.capacity();
+    for (int i = 0; i < 10000; i++) b.push_back(i);
+    for (int i = 0; i < 9000; i++) b.pop_front();
+    if (b.capacity() != cap || b.spare_n == 0) return false;
+    b.shrink_to_fit();
+    // the list keeps its slabs while nodes are in use
+    if (b.spare != nullptr || b.spare_n != 0 || b.spare_floor != 0 || b.capacity() > cap) return false;
+    for (int i = 0; i < 1000; i++)
+        if (b[i] != 9000 + i) return false;
+    b.clear();
+    b.shrink_to_fit();
+    return b.capacity() == 0;
+}
+
+// without reserve only a few emptied chunks are kept
+template <typename Q>
+bool spareTest() {
+    Q b;
+    for (int round = 0; round < 20; round++) {
+        for (int i = 0; i < 3000; i++) b.push_back(i);
+        for (int i = 0; i < 3000; i++) b.pop_front();
+        if (b.spare_n > Q::spare_high) return false;
+    }
+    // going back and forth over a chunk boundary reuses one chunk
+    for (int i = 0; i < 100; i++) b.push_back(i);
+    size_t spare = b.spare_n;
+    for (int i = 0; i < 1000; i++) {
+        b.push_back(i);
+        b.push_back(i);
+        b.pop_back();
+        b.pop_back();
+    }
+    return b.spare_n == spare && b.size() == 100;
+}
+
+// chunks shared with a snapshot are neither reserved into nor kept
+template <typename Q>
+bool snapshotTest() {
+    Q b;
+    std::deque<int> a;
+    for (int i = 0; i < 3000; i++) { b.push_back(i); a.push_back(i); }
+    Q s = b.snapshot();
+    b.reserve(6000);
+    for (int i = 0; i < 3000; i++) { b.push_front(i); b.pop_back(); }
+    b.shrink_to_fit();
+    return isEqual(a, s);
+}
+
+// swap and move leave the spare chunks with their own pool
+template <typename Q>
+bool swapTest() {
+    Q b, c;
+    b.reserve(1000);
+    c.push_back(1);
+    b.swap(c);
+    for (int i = 0; i < 1000; i++) c.push_back(i);
+    Q d(std::move(c));
+    return b.size() == 1 && d.size() == 1000 && c.spare_n == 0 && d.back() == 999;
+}
+
+bool reserveListTest() { return reserveTest<ListDeque>(); }
+bool reserveArrayTest() { return reserveTest<ArrayDeque>(); }
+bool shrinkListTest() { return shrinkTest<ListDeque>(); }
+bool shrinkArrayTest() { return shrinkTest<ArrayDeque>(); }
+bool spareListTest() { return spareTest<ListDeque>(); }
+bool spareArrayTest() { return spareTest<ArrayDeque>(); }
+bool snapshotListTest() { return snapshotTest<ListDeque>(); }
+bool snapshotArrayTest() { return snapshotTest<ArrayDeque>(); }
+bool swapListTest() { return swapTest<ListDeque>(); }
+bool swapArrayTest() { return swapTest<ArrayDeque>(); }
+
+int main() {
+    bool (*testFunc[])() = {
+        reserveListTest, reserveArrayTest, shrinkListTest, shrinkArrayTest, spareListTest,
+        spareArrayTest, snapshotListTest, snapshotArrayTest, swapListTest, swapArrayTest,
+    };
+    const char *testMessage[] = {
+        "Testing reserve (list)...", "Testing reserve (array)...", "Testing shrink_to_fit (list)...", "Testing shrink_to_fit (array)...",
+        "Testing spare chunks (list)...", "Testing spare chunks (array)...", "Testing reserve with a snapshot (list)...", "Testing reserve with a snapshot (array)...",
+        "Testing swap with spare chunks (list)...", "Testing swap with spare chunks (array)...",
+    };
+
+    bool error = false;
+    for (int i = 0; i < (int)(sizeof(testFunc) / sizeof(testFunc[0])); i++) {
+        printf("%-45s", testMessage[i]);
+        if (testFunc[i]())
+            printf("Passed\n");
+        else {
+            error = true;
+            printf("Failed !!!\n");
+        }
+    }
+
+    if (error)
+        printf("\nUnfortunately, you failed in this test\n\a");
+    else
+        printf("\nCongratulations, your deque passed all the tests!\n");
+
+    return 0;
+}
@@ -0,0 +1,157 @@
+// parallel::for_each and parallel::transform, for both chunk types
+
+#include <iostream>
+#include <deque>
+#include <atomic>
+#include <stdexcept>
+
+#include "deque.hpp"
+
+static const int N = 50000;
+
+typedef sjtu::deque<int> ListDeque;
+typedef sjtu::deque<int, sjtu::circular_array<int>> ArrayDeque;
+
+template <typename Q>
+void build(std::deque<int> &a, Q &b) {
+    for (int i = 0; i < N; i++) {
+        int x = (i * 7919) % 10007;
+        if (i % 2) { a.push_back(x); b.push_back(x); }
+        else { a.push_front(x); b.push_front(x); }
+    }
+}
+
+template <typename Ans, typename Test>
+bool isEqual(Ans &ans, Test &test) {
+    if (ans.size() != test.size())
+        return false;
+    for (int i = 0; i < (int)ans.size(); i++)
+        if (ans[i] != test[i]) return false;
+    return true;
+}
+
+// every element visited once whatever the thread count
+template <typename Q>
+bool forEachTest() {
+    for (size_t threads : {1, 2, 3, 8, 0}) {
+        std::deque<int> a;
+        Q b;
+        build(a, b);
+        std::atomic<long> sum(0);
+        sjtu::parallel::for_each(b, [&](int &x) { sum += x; x = x * 2 + 1; }, threads);
+        long expect = 0;
+        for (auto &x : a) { expect += x; x = x * 2 + 1; }
+        if (sum != expect || !isEqual(a, b)) return false;
+    }
+    return true;
+}
+
+template <typename Q>
+bool transformTest() {
+    for (size_t threads : {1, 4, 0}) {
+        std::deque<int> a;
+        Q b;
+        build(a, b);
+        sjtu::parallel::transform(b, [](int x) { return x % 97; }, threads);
+        for (auto &x : a) x %= 97;
+        // into a deque of another type and chunk
+        sjtu::deque<long long, sjtu::circular_array<long long>> c;
+        c.push_back(-1);
+        sjtu::parallel::transform(b, c, [](int x) { return (long long)x * x; }, threads);
+        std::deque<long long> d;
+        for (int x : a) d.push_back((long long)x * x);
+        ListDeque e;
+        sjtu::parallel::transform(b, e, [](int x) { return -x; }, threads);
+        if (!isEqual(a, b) || !isEqual(d, c) || e.size() != a.size() || e[N / 2] != -a[N / 2]) return false;
+        // the parts were linked in: pushes on the result still work
+        c.push_front(7);
+        c.push_back(8);
+        if (c.front() != 7 || c.back() != 8 || c[1] != d[0]) return false;
+    }
+    return true;
+}
+
+// an exception from f comes out after every thread is done, and the
+// deque is still usable
+template <typename Q>
+bool exceptionTest() {
+    std::deque<int> a;
+    Q b;
+    build(a, b);
+    bool thrown = false;
+    try {
+        sjtu::parallel::for_each(b, [](int &x) { if (x == 5000) throw std::runtime_error("f"); }, 4);
+    } catch (std::runtime_error &) {
+        thrown = true;
+    }
+    b.push_back(1);
+    a.push_back(1);
+    return thrown && isEqual(a, b);
+}
+
+// writes through for_each must not reach a snapshot
+template <typename Q>
+bool snapshotTest() {
+    std::deque<int> a;
+    Q b;
+    build(a, b);
+    Q s = b.snapshot();
+    sjtu::parallel::for_each(b, [](int &x) { x = -x; }, 4);
+    for (int i = 0; i < N; i++)
+        if (s[i] != a[i] || b[i] != -a[i]) return false;
+    return true;
+}
+
+// an empty deque and one smaller than the thread count
+template <typename Q>
+bool smallTest() {
+    Q b;
+    int calls = 0;
+    sjtu::parallel::for_each(b, [&](int &) { calls++; }, 8);
+    ListDeque c;
+    sjtu::parallel::transform(b, c, [](int x) { return x; }, 8);
+    b.push_back(3);
+    sjtu::parallel::for_each(b, [&](int &x) { calls++; x++; }, 8);
+    return calls == 1 && c.empty() && b[0] == 4;
+}
+
+bool forEachListTest() { return forEachTest<ListDeque>(); }
+bool forEachArrayTest() { return forEachTest<ArrayDeque>(); }
+bool transformListTest() { return transformTest<ListDeque>(); }
+bool transformArrayTest() { return transformTest<ArrayDeque>(); }
+bool exceptionListTest() { return exceptionTest<ListDeque>(); }
+bool exceptionArrayTest() { return exceptionTest<ArrayDeque>(); }
+bool snapshotListTest() { return snapshotTest<ListDeque>(); }
+bool snapshotArrayTest() { return snapshotTest<ArrayDeque>(); }
+bool smallListTest() { return smallTest<ListDeque>(); }
+bool smallArrayTest() { return smallTest<ArrayDeque>(); }
+
+int main() {
+    bool (*testFunc[])() = {
+        forEachListTest, forEachArrayTest, transformListTest, transformArrayTest, exceptionListTest,
+        exceptionArrayTest, snapshotListTest, snapshotArrayTest, smallListTest, smallArrayTest,
+    };
+    const char *testMessage[] = {
+        "Testing parallel for_each (list)...", "Testing parallel for_each (array)...", "Testing parallel transform (list)...", "Testing parallel transform (array)...",
+        "Testing exceptions from f (list)...", "Testing exceptions from f (array)...", "Testing for_each on a snapshot (list)...", "Testing for_each on a snapshot (array)...",
+        "Testing tiny deques (list)...", "Testing tiny deques (array)...",
+    };
+
+    bool error = false;
+    for (int i = 0; i < (int)(sizeof(testFunc) / sizeof(testFunc[0])); i++) {
+        printf("%-45s", testMessage[i]);
+        if (testFunc[i]())
+            printf("Passed\n");
+        else {
+            error = true;
+            printf("Failed !!!\n");
+        }
+    }
+
+    if (error)
+        printf("\nUnfortunately, you failed in this test\n\a");
+    else
+        printf("\nCongratulations, your deque passed all the tests!\n");
+
+    return 0;
+}
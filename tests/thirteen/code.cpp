@@ -0,0 +1,152 @@
+// concurrent_deque: any number of threads at both ends
+
+#include <iostream>
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <vector>
+
+#include "deque.hpp"
+
+static const long N = 200000;
+static const int THREADS = 4;
+
+static std::atomic<unsigned char> seen[N];
+
+// one thread: the same as std::deque, through chunk merges and splits
+bool sequentialTest() {
+    sjtu::concurrent_deque<int, 64> q;
+    std::deque<int> a;
+    unsigned seed = 1;
+    for (int i = 0; i < 20000; i++) {
+        seed = seed * 1103515245 + 12345;
+        int x = seed >> 8, y;
+        switch (x % 6) {
+        case 0: q.push_back(x); a.push_back(x); break;
+        case 1: q.push_front(x); a.push_front(x); break;
+        case 2: if (q.try_pop_back(y) != !a.empty() || (!a.empty() && y != a.back())) return false;
+                if (!a.empty()) a.pop_back();
+                break;
+        case 3: if (q.try_pop_front(y) != !a.empty() || (!a.empty() && y != a.front())) return false;
+                if (!a.empty()) a.pop_front();
+                break;
+        case 4: q.insert(x % (a.size() + 1), x); a.insert(a.begin() + x % (a.size() + 1), x); break;
+        default: if (!a.empty()) { q.erase(x % a.size()); a.erase(a.begin() + x % a.size()); }
+        }
+        if (q.size() != a.size()) return false;
+    }
+    bool thrown = false;
+    try {
+        q.erase(a.size());
+    } catch (sjtu::index_out_of_bound &) {
+        thrown = true;
+    }
+    int y;
+    for (size_t i = 0; i < a.size(); i++)
+        if (!q.try_pop_front(y) || y != a[i]) return false;
+    return thrown && q.empty() && !q.try_pop_back(y);
+}
+
+// pushers at both ends and poppers at both ends: every value comes out once
+template <size_t Bytes>
+bool threadTest() {
+    sjtu::concurrent_deque<long, Bytes> q;
+    for (long i = 0; i < N; i++) seen[i] = 0;
+    std::atomic<long> next(0), got(0);
+    std::vector<std::thread> th;
+    for (int k = 0; k < THREADS; k++)
+        th.emplace_back([&, k] {
+            long x;
+            while (got < N) {
+                long i = next.fetch_add(1);
+                if (i < N) {
+                    if (k % 2) q.push_back(i);
+                    else q.push_front(i);
+                }
+                bool ok = (i + k) % 2 ? q.try_pop_front(x) : q.try_pop_back(x);
+                if (ok) {
+                    seen[x]++;
+                    got++;
+                }
+            }
+        });
+    for (auto &t : th) t.join();
+    for (long i = 0; i < N; i++)
+        if (seen[i] != 1) return false;
+    return q.empty();
+}
+
+// the back end is fed by one thread and read by another: per producer,
+// what one end pushes the other end pops in the same order
+bool orderTest() {
+    sjtu::concurrent_deque<long, 128> q;
+    bool ok = true;
+    std::thread consumer([&] {
+        long last = -1, x;
+        for (long k = 0; k < N; ) {
+            if (q.try_pop_front(x)) {
+                ok = ok && x == last + 1;
+                last = x;
+                k++;
+            }
+        }
+    });
+    for (long i = 0; i < N; i++) q.push_back(i);
+    consumer.join();
+    return ok && q.empty();
+}
+
+// insert and erase in the middle while the ends are busy
+bool middleTest() {
+    sjtu::concurrent_deque<long, 64> q;
+    for (long i = 0; i < 1000; i++) q.push_back(0);
+    std::atomic<bool> done(false);
+    std::thread ends([&] {
+        long x;
+        for (long i = 0; i < 50000; i++) {
+            q.push_front(1);
+            q.push_back(1);
+            q.try_pop_front(x);
+            q.try_pop_back(x);
+        }
+        done = true;
+    });
+    while (!done) {
+        size_t n = q.size();
+        q.insert(n / 2, 2);
+        q.erase(q.size() / 3);
+    }
+    ends.join();
+    return q.size() == 1000;
+}
+
+bool threadSmallTest() { return threadTest<64>(); }
+bool threadPageTest() { return threadTest<4096>(); }
+
+int main() {
+    bool (*testFunc[])() = {
+        sequentialTest, threadSmallTest, threadPageTest, orderTest, middleTest,
+    };
+    const char *testMessage[] = {
+        "Testing one thread...", "Testing four threads (small chunks)...", "Testing four threads (page chunks)...", "Testing order across threads...",
+        "Testing insert / erase with busy ends...",
+    };
+
+    bool error = false;
+    for (int i = 0; i < (int)(sizeof(testFunc) / sizeof(testFunc[0])); i++) {
+        printf("%-45s", testMessage[i]);
+        if (testFunc[i]())
+            printf("Passed\n");
+        else {
+            error = true;
+            printf("Failed !!!\n");
+        }
+    }
+
+    if (error)
+        printf("\nUnfortunately, you failed in this test\n\a");
+    else
+        printf("\nCongratulations, your deque passed all the tests!\n");
+
+    return 0;
+}
@@ -0,0 +1,130 @@
+// spsc_deque: one producer thread, one consumer thread
+
+#include <iostream>
+#include <thread>
+#include <string>
+
+#include "deque.hpp"
+
+static const long N = 300000;
+
+bool sequentialTest() {
+    sjtu::spsc_deque<int, 64> q;
+    if (!q.empty()) return false;
+    int x;
+    if (q.try_pop_front(x)) return false;
+    bool thrown = false;
+    try {
+        q.pop_front();
+    } catch (sjtu::container_is_empty &) {
+        thrown = true;
+    }
+    if (!thrown) return false;
+    // many chunks of 16, emptied and filled again so the spare chunk is used
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 1000; i++) q.push_back(i);
+        if (q.size() != 1000 || q.front() != 0) return false;
+        for (int i = 0; i < 1000; i++) {
+            if (i % 2) {
+                if (!q.try_pop_front(x) || x != i) return false;
+            } else {
+                if (q.front() != i) return false;
+                q.pop_front();
+            }
+        }
+        if (!q.empty() || q.try_pop_front(x)) return false;
+    }
+    return true;
+}
+
+// elements not popped are destroyed with the deque
+bool destructorTest() {
+    static int live = 0;
+    struct Counted {
+        int v;
+        Counted(int v_) : v(v_) { live++; }
+        Counted(const Counted &o) : v(o.v) { live++; }
+        Counted &operator=(const Counted &o) { v = o.v; return *this; }
+        ~Counted() { live--; }
+    };
+    {
+        sjtu::spsc_deque<Counted, 64> q;
+        for (int i = 0; i < 100; i++) q.emplace_back(i);
+        for (int i = 0; i < 30; i++) q.pop_front();
+        if (live != 70) return false;
+    }
+    return live == 0;
+}
+
+template <size_t Bytes>
+bool threadTest() {
+    sjtu::spsc_deque<long, Bytes> q;
+    long sum = 0, expect = 0;
+    bool inOrder = true;
+    std::thread consumer([&] {
+        long next = 0, x;
+        while (next < N) {
+            if (q.try_pop_front(x)) {
+                inOrder = inOrder && x == next;
+                sum += x;
+                next++;
+            }
+        }
+    });
+    for (long i = 0; i < N; i++) {
+        q.push_back(i);
+        expect += i;
+    }
+    consumer.join();
+    return inOrder && sum == expect && q.empty();
+}
+
+// a type that isn't trivially copyable goes through the chunks intact
+bool stringTest() {
+    sjtu::spsc_deque<std::string, 256> q;
+    bool ok = true;
+    std::thread consumer([&] {
+        std::string s;
+        for (int i = 0; i < 20000; ) {
+            if (q.try_pop_front(s)) {
+                ok = ok && s == std::to_string(i) + std::string(i % 40, 'x');
+                i++;
+            }
+        }
+    });
+    for (int i = 0; i < 20000; i++)
+        q.push_back(std::to_string(i) + std::string(i % 40, 'x'));
+    consumer.join();
+    return ok && q.empty();
+}
+
+bool threadSmallTest() { return threadTest<64>(); }
+bool threadPageTest() { return threadTest<4096>(); }
+
+int main() {
+    bool (*testFunc[])() = {
+        sequentialTest, destructorTest, threadSmallTest, threadPageTest, stringTest,
+    };
+    const char *testMessage[] = {
+        "Testing one thread...", "Testing destructor...", "Testing two threads (small chunks)...", "Testing two threads (page chunks)...",
+        "Testing strings across threads...",
+    };
+
+    bool error = false;
+    for (int i = 0; i < (int)(sizeof(testFunc) / sizeof(testFunc[0])); i++) {
+        printf("%-45s", testMessage[i]);
+        if (testFunc[i]())
+            printf("Passed\n");
+        else {
+            error = true;
+            printf("Failed !!!\n");
+        }
+    }
+
+    if (error)
+        printf("\nUnfortunately, you failed in this test\n\a");
+    else
+        printf("\nCongratulations, your deque passed all the tests!\n");
+
+    return 0;
+}
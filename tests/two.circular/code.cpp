@@ -0,0 +1,10 @@
+// tests/two with circular_array as the chunk, the suite itself is unchanged:
+// its sjtu::deque<T> names circular_test::deque<T> below
+#include "deque.hpp"
+
+namespace circular_test {
+template <class T> using deque = sjtu::deque<T, sjtu::circular_array<T>>;
+}
+#define sjtu circular_test
+
+#include "../two/code.cpp"